@@ -0,0 +1,3 @@
+#define PATO_VERSION "1.0.1"
+#define PATO_DESCRIPTION "high PerformAnce TriplexatOr"
+#define PATO_HOMEPAGE_URL "https://github.com/UDC-GAC/PATO"
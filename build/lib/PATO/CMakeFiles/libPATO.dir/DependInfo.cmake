@@ -0,0 +1,27 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/lib/PATO/guanine_filter.cpp" "lib/PATO/CMakeFiles/libPATO.dir/guanine_filter.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/guanine_filter.cpp.o.d"
+  "/root/repo/lib/PATO/match_queue.cpp" "lib/PATO/CMakeFiles/libPATO.dir/match_queue.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/match_queue.cpp.o.d"
+  "/root/repo/lib/PATO/output_writer.cpp" "lib/PATO/CMakeFiles/libPATO.dir/output_writer.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/output_writer.cpp.o.d"
+  "/root/repo/lib/PATO/repeat_filter.cpp" "lib/PATO/CMakeFiles/libPATO.dir/repeat_filter.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/repeat_filter.cpp.o.d"
+  "/root/repo/lib/PATO/segment_parser.cpp" "lib/PATO/CMakeFiles/libPATO.dir/segment_parser.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/segment_parser.cpp.o.d"
+  "/root/repo/lib/PATO/sequence_loader.cpp" "lib/PATO/CMakeFiles/libPATO.dir/sequence_loader.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/sequence_loader.cpp.o.d"
+  "/root/repo/lib/PATO/tfo_finder.cpp" "lib/PATO/CMakeFiles/libPATO.dir/tfo_finder.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/tfo_finder.cpp.o.d"
+  "/root/repo/lib/PATO/tpx_finder.cpp" "lib/PATO/CMakeFiles/libPATO.dir/tpx_finder.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/tpx_finder.cpp.o.d"
+  "/root/repo/lib/PATO/tts_finder.cpp" "lib/PATO/CMakeFiles/libPATO.dir/tts_finder.cpp.o" "gcc" "lib/PATO/CMakeFiles/libPATO.dir/tts_finder.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
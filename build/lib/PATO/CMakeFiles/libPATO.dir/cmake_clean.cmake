@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/libPATO.dir/guanine_filter.cpp.o"
+  "CMakeFiles/libPATO.dir/guanine_filter.cpp.o.d"
+  "CMakeFiles/libPATO.dir/match_queue.cpp.o"
+  "CMakeFiles/libPATO.dir/match_queue.cpp.o.d"
+  "CMakeFiles/libPATO.dir/output_writer.cpp.o"
+  "CMakeFiles/libPATO.dir/output_writer.cpp.o.d"
+  "CMakeFiles/libPATO.dir/repeat_filter.cpp.o"
+  "CMakeFiles/libPATO.dir/repeat_filter.cpp.o.d"
+  "CMakeFiles/libPATO.dir/segment_parser.cpp.o"
+  "CMakeFiles/libPATO.dir/segment_parser.cpp.o.d"
+  "CMakeFiles/libPATO.dir/sequence_loader.cpp.o"
+  "CMakeFiles/libPATO.dir/sequence_loader.cpp.o.d"
+  "CMakeFiles/libPATO.dir/tfo_finder.cpp.o"
+  "CMakeFiles/libPATO.dir/tfo_finder.cpp.o.d"
+  "CMakeFiles/libPATO.dir/tpx_finder.cpp.o"
+  "CMakeFiles/libPATO.dir/tpx_finder.cpp.o.d"
+  "CMakeFiles/libPATO.dir/tts_finder.cpp.o"
+  "CMakeFiles/libPATO.dir/tts_finder.cpp.o.d"
+  "libPATO.a"
+  "libPATO.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/libPATO.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/PATO.dir/main.cpp.o"
+  "CMakeFiles/PATO.dir/main.cpp.o.d"
+  "PATO"
+  "PATO.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/PATO.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
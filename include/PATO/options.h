@@ -47,6 +47,12 @@ enum class error_reference_t : unsigned {
   last = 3,
 };
 
+enum class tpx_backend_t : unsigned {
+  scalar = 0,
+  batched = 1,
+  last = 2,
+};
+
 struct options_t {
   seqan::CharString tfo_file;
   seqan::CharString tts_file;
@@ -63,6 +69,7 @@ struct options_t {
   int maximal_error;
 
   unsigned chunk_size;
+  std::size_t chunk_bases;
   unsigned min_block_run;
   unsigned min_repeat_length;
   unsigned max_repeat_period;
@@ -71,6 +78,7 @@ struct options_t {
   run_mode_t run_mode;
   output_format_t output_format;
   error_reference_t error_reference;
+  tpx_backend_t tpx_backend;
 
   bool tc_motif;
   bool ga_motif;
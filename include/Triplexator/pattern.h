@@ -46,9 +46,6 @@ public:
   typedef typename Host<ModStringTriplex>::Type THost;
   typedef typename Infix<THost>::Type TSegment;
   typedef unsigned TId;
-  typedef Pair<TId, typename Position<ModStringTriplex<THost_, TString>>::Type>
-      TDuplicate;
-  typedef ::std::vector<TDuplicate> TDuplicates;
 
   typedef ModifiedString<TSegment, ModView<FunctorTCMotif>> TtcMotif;
   typedef ModifiedString<TSegment, ModView<FunctorGTMotif>> TgtMotif;
@@ -63,7 +60,6 @@ public:
       ModifiedString<TSegment, ModView<FunctorTTSMotifCompl>>, ModReverse>
       TttsMotifRevComp;
 
-  TString mask_string; // a string which masks the host segment
   bool parallel;       // whether the motif string is parallel or antiparallel
                        // oriented to the host
   TSegment segment;    // the host segment masked by the string
@@ -72,27 +68,46 @@ public:
   bool isTFO; // indicates whether this is a TFO (=true) or a TTS (=false)
   char motif; // the motif of the triplex
   unsigned int score;
-  TDuplicates duplicates;
 
-  void _updateMaskString() {
+  // The string which masks the host segment is not stored but viewed on
+  // demand: f is called with the masking view of the segment
+  template <typename TFunctor> void _visitMask(TFunctor &&f) const {
+    TSegment seg(segment);
     if (!isTFO) {
-      if (motif == '+')
-        mask_string = TttsMotif(segment);
-      else
-        mask_string = TttsMotifRevComp(segment);
+      if (motif == '+') {
+        TttsMotif mask(seg);
+        f(mask);
+        return;
+      } else {
+        TttsMotifRevComp mask(seg);
+        f(mask);
+        return;
+      }
     } else {
       if (parallel) {
-        if (motif == 'M')
-          mask_string = TgtMotif(segment);
-        else if (motif == 'Y')
-          mask_string = TtcMotif(segment);
+        if (motif == 'M') {
+          TgtMotif mask(seg);
+          f(mask);
+          return;
+        } else if (motif == 'Y') {
+          TtcMotif mask(seg);
+          f(mask);
+          return;
+        }
       } else {
-        if (motif == 'M')
-          mask_string = TgtMotifRev(segment);
-        else if (motif == 'R')
-          mask_string = TgaMotif(segment);
+        if (motif == 'M') {
+          TgtMotifRev mask(seg);
+          f(mask);
+          return;
+        } else if (motif == 'R') {
+          TgaMotif mask(seg);
+          f(mask);
+          return;
+        }
       }
     }
+    TString mask;
+    f(mask);
   }
 
 public:
@@ -100,16 +115,12 @@ public:
                    bool _parallel_orientation, unsigned _seqNo, bool _isTFO,
                    char _motif)
       : parallel(_parallel_orientation), segment(_host), seqNo(_seqNo),
-        copies(-1), isTFO(_isTFO), motif(_motif) {
-    _updateMaskString();
-  }
+        copies(-1), isTFO(_isTFO), motif(_motif) {}
 
   ModStringTriplex(TSegment _segment, bool _parallel_orientation,
                    unsigned _seqNo, bool _isTFO, char _motif)
       : parallel(_parallel_orientation), segment(_segment), seqNo(_seqNo),
-        copies(-1), isTFO(_isTFO), motif(_motif) {
-    _updateMaskString();
-  }
+        copies(-1), isTFO(_isTFO), motif(_motif) {}
 
   ModStringTriplex(typename Parameter_<THost>::Type _host,
                    typename Position<THost>::Type _begin_index,
@@ -118,9 +129,7 @@ public:
                    char _motif)
       : parallel(_parallel_orientation),
         segment(_host, _begin_index, _end_index), seqNo(_seqNo), copies(-1),
-        isTFO(_isTFO), motif(_motif) {
-    _updateMaskString();
-  }
+        isTFO(_isTFO), motif(_motif) {}
 
   ModStringTriplex(typename Parameter_<THost>::Type _host,
                    typename Position<THost>::Type _begin_index,
@@ -129,9 +138,7 @@ public:
                    char _motif, unsigned _copies)
       : parallel(_parallel_orientation),
         segment(_host, _begin_index, _end_index), seqNo(_seqNo),
-        copies(_copies), isTFO(_isTFO), motif(_motif) {
-    _updateMaskString();
-  }
+        copies(_copies), isTFO(_isTFO), motif(_motif) {}
 
   ModStringTriplex(typename Parameter_<THost>::Type _host,
                    typename Iterator<THost, Standard>::Type _begin,
@@ -139,9 +146,7 @@ public:
                    bool _parallel_orientation, unsigned _seqNo, bool _isTFO,
                    char _motif, int _copies)
       : parallel(_parallel_orientation), segment(_host, _begin, _end),
-        seqNo(_seqNo), copies(_copies), isTFO(_isTFO), motif(_motif) {
-    _updateMaskString();
-  }
+        seqNo(_seqNo), copies(_copies), isTFO(_isTFO), motif(_motif) {}
 
   template <typename TSource>
   inline ModStringTriplex &operator=(TSource const &source) {
@@ -150,27 +155,23 @@ public:
   }
 
   template <typename TPos>
-  inline typename Reference<ModStringTriplex>::Type operator[](TPos pos) {
-    return value(*this, pos);
-  }
-
-  template <typename TPos>
-  inline typename Reference<ModStringTriplex const>::Type
-  operator[](TPos pos) const {
+  inline typename Value<TString>::Type operator[](TPos pos) const {
     return value(*this, pos);
   }
 };
 
 template <typename THost, typename TString, typename TPos>
-inline typename Reference<ModStringTriplex<THost, TString>>::Type
-value(ModStringTriplex<THost, TString> &me, TPos pos) {
-  return *(begin(me.mask_string, Standard()) + pos);
+inline typename Value<TString>::Type
+value(ModStringTriplex<THost, TString> const &me, TPos pos) {
+  typename Value<TString>::Type c;
+  me._visitMask([&](auto &mask) { c = value(mask, pos); });
+  return c;
 }
 
-template <typename THost, typename TString, typename TPos>
-inline typename Reference<ModStringTriplex<THost, TString> const>::Type
-value(ModStringTriplex<THost, TString> const &me, TPos pos) {
-  return *(begin(me.mask_string, Standard()) + pos);
+template <typename THost, typename TString, typename TFunctor>
+inline void visitMask(ModStringTriplex<THost, TString> const &me,
+                      TFunctor &&f) {
+  me._visitMask(f);
 }
 
 template <typename THost_, typename TString>
@@ -192,19 +193,6 @@ inline TStream &operator<<(TStream &target,
   return target;
 }
 
-template <typename THost_, typename TString>
-inline typename Iterator<ModStringTriplex<THost_, TString>, Standard>::Type
-begin(ModStringTriplex<THost_, TString> &me, Standard) {
-  return begin(me.mask_string);
-}
-
-template <typename THost_, typename TString>
-inline
-    typename Iterator<ModStringTriplex<THost_, TString> const, Standard>::Type
-    begin(ModStringTriplex<THost_, TString> const &me, Standard) {
-  return begin(me.mask_string);
-}
-
 template <typename THost_, typename TString>
 bool merge(ModStringTriplex<THost_, TString> &m1,
            ModStringTriplex<THost_, TString> &m2) {
@@ -214,7 +202,6 @@ bool merge(ModStringTriplex<THost_, TString> &m1,
   else {
     setBeginPosition(m1, std::min(beginPosition(m1), beginPosition(m2)));
     setEndPosition(m1, std::max(endPosition(m1), endPosition(m2)));
-    m1._updateMaskString();
     return true;
   }
 }
@@ -240,37 +227,6 @@ inline bool isParallel(ModStringTriplex<THost_, TString> const &me) {
   return me.parallel;
 }
 
-template <typename THost_, typename TString, typename TId, typename TPos>
-inline void addDuplicate(ModStringTriplex<THost_, TString> &me,
-                         TId const &seqnr, TPos const &pos) {
-  typename ModStringTriplex<THost_, TString>::TDuplicate d(seqnr, pos);
-  appendValue(me.duplicates, d);
-}
-
-template <typename THost_, typename TString>
-inline typename ModStringTriplex<THost_, TString>::TDuplicates
-getDuplicates(ModStringTriplex<THost_, TString> &me) {
-  return me.duplicates;
-}
-
-template <typename THost_, typename TString>
-inline typename ModStringTriplex<THost_, TString>::TDuplicates
-getDuplicates(ModStringTriplex<THost_, TString> const &me) {
-  return me.duplicates;
-}
-
-template <typename THost_, typename TString, typename TIndex>
-inline typename ModStringTriplex<THost_, TString>::TDuplicate
-getDuplicateAt(ModStringTriplex<THost_, TString> &me, TIndex const &pos) {
-  return value(me.duplicates, pos);
-}
-
-template <typename THost_, typename TString, typename TIndex>
-inline typename ModStringTriplex<THost_, TString>::TDuplicate
-getDuplicateAt(ModStringTriplex<THost_, TString> const &me, TIndex const &pos) {
-  return value(me.duplicates, pos);
-}
-
 template <typename THost_, typename TString>
 inline bool isTFO(ModStringTriplex<THost_, TString> &me) {
   return me.isTFO;
@@ -322,19 +278,6 @@ inline void setBeginPosition(ModStringTriplex<THost_, TString_> &me,
   setBeginPosition(me.segment, new_begin);
 }
 
-template <typename THost_, typename TString_>
-inline typename Iterator<ModStringTriplex<THost_, TString_>, Standard>::Type
-end(ModStringTriplex<THost_, TString_> &me, Standard) {
-  return end(me.mask_string);
-}
-
-template <typename THost_, typename TString_>
-inline
-    typename Iterator<ModStringTriplex<THost_, TString_> const, Standard>::Type
-    end(ModStringTriplex<THost_, TString_> const &me, Standard) {
-  return end(me.mask_string);
-}
-
 template <typename THost_, typename TString>
 inline typename Position<ModStringTriplex<THost_, TString>>::Type
 endPosition(ModStringTriplex<THost_, TString> &me) {
@@ -377,8 +320,9 @@ getSegment(ModStringTriplex<THost, TString> const &me) {
 template <typename THost, typename TString>
 inline double guanineRate(ModStringTriplex<THost, TString> &me) {
   double guanines = 0.;
+  TString mask = ttsString(me);
   for (unsigned i = 0; i < length(me); ++i) {
-    if (value(me.mask_string, i) == 'G' || value(me.mask_string, i) == 'g')
+    if (value(mask, i) == 'G' || value(mask, i) == 'g')
       ++guanines;
   }
   return guanines / length(me);
@@ -387,8 +331,9 @@ inline double guanineRate(ModStringTriplex<THost, TString> &me) {
 template <typename THost, typename TString>
 inline double guanineRate(ModStringTriplex<THost, TString> const &me) {
   double guanines = 0.;
+  TString mask = ttsString(me);
   for (unsigned i = 0; i < length(me); ++i) {
-    if (value(me.mask_string, i) == 'G' || value(me.mask_string, i) == 'g')
+    if (value(mask, i) == 'G' || value(mask, i) == 'g')
       ++guanines;
   }
   return guanines / length(me);
@@ -447,13 +392,10 @@ errorString(ModStringTriplex<THost, TString> const &me) {
 }
 
 template <typename THost, typename TString>
-inline TString ttsString(ModStringTriplex<THost, TString> &me) {
-  return me.mask_string;
-}
-
-template <typename THost, typename TString>
-inline TString const ttsString(ModStringTriplex<THost, TString> const &me) {
-  return me.mask_string;
+inline TString ttsString(ModStringTriplex<THost, TString> const &me) {
+  TString mask;
+  me._visitMask([&](auto &view) { assign(mask, view); });
+  return mask;
 }
 
 template <typename THost, typename TString>
@@ -639,8 +581,9 @@ inline TString substr(ModStringTriplex<THost, TString> &me, int beginPos,
   ::std::string tmp_sub;
   tmp_sub.reserve(endPos - beginPos);
 
-  TIter it = begin(me.mask_string, Rooted());
-  TIter itEnd = begin(me.mask_string, Rooted());
+  TString mask = ttsString(me);
+  TIter it = begin(mask, Rooted());
+  TIter itEnd = begin(mask, Rooted());
   goFurther(it, beginPos);
   goFurther(itEnd, endPos);
   for (; it != itEnd; ++it) {
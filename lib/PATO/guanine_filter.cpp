@@ -22,69 +22,213 @@
 
 #include "guanine_filter.h"
 
-#include <seqan/misc/interval_tree.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 
-static void increase_right(pato::char_vector_vector_t &encoded_seq,
-                           unsigned &pos, unsigned &filter_chars,
-                           unsigned &interrupt_chars,
-                           unsigned &non_filter_chars) {
-  filter_chars += encoded_seq[0][pos];
-  interrupt_chars += encoded_seq[1][pos];
-  non_filter_chars += encoded_seq[2][pos];
+#include <seqan/misc/bit_twiddling.h>
 
-  ++pos;
+// Number of set bits in [0, pos): the rank of the word that holds pos plus
+// the set bits that precede pos within that word.
+static unsigned count_set_bits(const pato::rank_vector_t &bits, unsigned pos) {
+  uint64_t mask = (uint64_t{1} << (pos & 63)) - 1;
+  return bits.ranks[pos >> 6] + seqan::popCount(bits.words[pos >> 6] & mask);
 }
 
-static void increase_left(pato::char_vector_vector_t &encoded_seq,
-                          unsigned &pos, unsigned &filter_chars,
-                          unsigned &interrupt_chars,
-                          unsigned &non_filter_chars) {
-  filter_chars -= encoded_seq[0][pos];
-  interrupt_chars -= encoded_seq[1][pos];
-  non_filter_chars -= encoded_seq[2][pos];
+static bool is_bit_set(const pato::rank_vector_t &bits, unsigned pos) {
+  return (bits.words[pos >> 6] >> (pos & 63)) & 1;
+}
+
+namespace {
+
+// The sliding window reads the encoded sequence either as it is or mirrored,
+// as the reverse of the motif is what an antiparallel motif sees
+using forward_view_t = seqan::Tag<struct _forward_view>;
+using mirrored_view_t = seqan::Tag<struct _mirrored_view>;
+
+} // namespace
+
+static unsigned char_position(unsigned pos,
+                              [[maybe_unused]] unsigned motif_length,
+                              [[maybe_unused]] const forward_view_t &view) {
+  return pos;
+}
+
+static unsigned char_position(unsigned pos, unsigned motif_length,
+                              [[maybe_unused]] const mirrored_view_t &view) {
+  return motif_length - 1 - pos;
+}
+
+static unsigned boundary_position(unsigned pos,
+                                  [[maybe_unused]] unsigned motif_length,
+                                  [[maybe_unused]] const forward_view_t &view) {
+  return pos;
+}
+
+static unsigned
+boundary_position(unsigned pos, unsigned motif_length,
+                  [[maybe_unused]] const mirrored_view_t &view) {
+  return motif_length - pos;
+}
+
+static unsigned count_between(unsigned left_rank, unsigned right_rank,
+                              [[maybe_unused]] const forward_view_t &view) {
+  return right_rank - left_rank;
+}
+
+static unsigned count_between(unsigned left_rank, unsigned right_rank,
+                              [[maybe_unused]] const mirrored_view_t &view) {
+  return left_rank - right_rank;
+}
+
+template <typename view_t>
+static unsigned rank_at(const pato::rank_vector_t &bits, unsigned pos,
+                        unsigned motif_length, const view_t &view) {
+  return count_set_bits(bits, boundary_position(pos, motif_length, view));
+}
 
-  ++pos;
+template <typename view_t>
+static bool is_interrupt_char(const pato::encoded_sequence_t &encoded_seq,
+                              unsigned pos, unsigned motif_length,
+                              const view_t &view) {
+  return is_bit_set(encoded_seq.interrupt_chars,
+                    char_position(pos, motif_length, view));
 }
 
-static bool is_interrupt_char(pato::char_vector_vector_t &encoded_seq,
-                              unsigned pos) {
-  return encoded_seq[1][pos];
+template <typename view_t>
+static bool is_filter_char(const pato::encoded_sequence_t &encoded_seq,
+                           unsigned pos, unsigned motif_length,
+                           const view_t &view) {
+  return is_bit_set(encoded_seq.filter_chars,
+                    char_position(pos, motif_length, view));
+}
+
+template <typename view_t>
+static unsigned count_chars(const pato::rank_vector_t &bits, unsigned left,
+                            unsigned right, unsigned motif_length,
+                            const view_t &view) {
+  return count_between(rank_at(bits, left, motif_length, view),
+                       rank_at(bits, right, motif_length, view), view);
 }
 
 template <typename tag_t>
 static bool
-motif_specific_constraint([[maybe_unused]] double filter_rate,
+motif_specific_constraint([[maybe_unused]] int filter_chars,
+                          [[maybe_unused]] unsigned length,
                           [[maybe_unused]] pato::orientation_t ornt,
-                          [[maybe_unused]] const tag_t &tag,
-                          [[maybe_unused]] const pato::options_t &opts) {
+                          [[maybe_unused]] const pato::window_bounds_t &bounds,
+                          [[maybe_unused]] const tag_t &tag) {
   return true;
 }
 
-static bool
-motif_specific_constraint(double filter_rate, pato::orientation_t ornt,
-                          [[maybe_unused]] const pato::mixed_motif_t &tag,
-                          const pato::options_t &opts) {
+static bool motif_specific_constraint(
+    int filter_chars, unsigned length, pato::orientation_t ornt,
+    const pato::window_bounds_t &bounds,
+    [[maybe_unused]] const pato::mixed_motif_t &tag) {
   if (ornt != pato::orientation_t::parallel &&
-      filter_rate >= opts.mixed_antiparallel_min_guanine) {
+      filter_chars >= bounds.min_antiparallel_filter_chars[length]) {
     return true;
   } else if (ornt != pato::orientation_t::antiparallel &&
-             filter_rate <= opts.mixed_parallel_max_guanine) {
+             filter_chars <= bounds.max_parallel_filter_chars[length]) {
     return true;
   }
   return false;
 }
 
+// Largest count in [0, length] whose rate satisfies the predicate, or -1 if
+// there is none. The predicate must hold for a prefix of the counts, so the
+// estimate given by the rate only needs to be corrected by a few steps.
+template <typename predicate_t>
+static int max_count(unsigned length, double rate, predicate_t predicate) {
+  auto count = static_cast<int>(
+      std::clamp(std::floor(length * rate), -1.0, static_cast<double>(length)));
+  while (count < static_cast<int>(length) &&
+         predicate(static_cast<double>(count + 1) / length)) {
+    ++count;
+  }
+  while (count >= 0 && !predicate(static_cast<double>(count) / length)) {
+    --count;
+  }
+  return count;
+}
+
+// Smallest count in [0, length] whose rate satisfies the predicate, or
+// length + 1 if there is none. The predicate must hold for a suffix of the
+// counts.
+template <typename predicate_t>
+static int min_count(unsigned length, double rate, predicate_t predicate) {
+  auto count = static_cast<int>(std::clamp(std::ceil(length * rate), 0.0,
+                                           static_cast<double>(length + 1)));
+  while (count > 0 && predicate(static_cast<double>(count - 1) / length)) {
+    --count;
+  }
+  while (count <= static_cast<int>(length) &&
+         !predicate(static_cast<double>(count) / length)) {
+    ++count;
+  }
+  return count;
+}
+
+// The bounds evaluate the very same floating point comparisons that the rates
+// of a window would go through, so that filtering on counts gives identical
+// results. Windows never outgrow the motif, so the table is extended lazily.
+static void update_window_bounds(pato::window_bounds_t &bounds,
+                                 unsigned max_length,
+                                 const pato::options_t &opts) {
+  unsigned length = bounds.max_interrupt_chars.size();
+  if (length > max_length) {
+    return;
+  }
+
+  bounds.max_interrupt_chars.resize(max_length + 1);
+  bounds.min_filter_chars.resize(max_length + 1);
+  bounds.max_filter_chars.resize(max_length + 1);
+  bounds.min_antiparallel_filter_chars.resize(max_length + 1);
+  bounds.max_parallel_filter_chars.resize(max_length + 1);
+
+  for (; length <= max_length; ++length) {
+    bounds.max_interrupt_chars[length] =
+        max_count(length, opts.error_rate,
+                  [&](double rate) { return rate <= opts.error_rate; });
+    bounds.min_filter_chars[length] =
+        min_count(length, opts.min_guanine_rate,
+                  [&](double rate) { return opts.min_guanine_rate <= rate; });
+    bounds.max_filter_chars[length] =
+        max_count(length, opts.max_guanine_rate,
+                  [&](double rate) { return rate <= opts.max_guanine_rate; });
+    bounds.min_antiparallel_filter_chars[length] =
+        min_count(length, opts.mixed_antiparallel_min_guanine,
+                  [&](double rate) {
+                    return rate >= opts.mixed_antiparallel_min_guanine;
+                  });
+    bounds.max_parallel_filter_chars[length] =
+        max_count(length, opts.mixed_parallel_max_guanine, [&](double rate) {
+          return rate <= opts.mixed_parallel_max_guanine;
+        });
+  }
+}
+
+static bool is_parallel(pato::motif_t &motif,
+                        [[maybe_unused]] const forward_view_t &view) {
+  return seqan::isParallel(motif);
+}
+
+static bool is_parallel(pato::motif_t &motif,
+                        [[maybe_unused]] const mirrored_view_t &view) {
+  return !seqan::isParallel(motif);
+}
+
 static void add_match(pato::motif_vector_t &motifs, pato::motif_t &motif,
                       unsigned start, unsigned end, unsigned errors,
-                      [[maybe_unused]] const pato::tfo_t &tag) {
+                      bool parallel, [[maybe_unused]] const pato::tfo_t &tag) {
   auto motif_length = seqan::length(motif);
-  auto st = seqan::isParallel(motif) ? start : motif_length - end;
-  auto nd = seqan::isParallel(motif) ? end : motif_length - start;
+  auto st = parallel ? start : motif_length - end;
+  auto nd = parallel ? end : motif_length - start;
 
   pato::motif_t tmp_motif{seqan::host(motif),
                           seqan::beginPosition(motif) + st,
                           seqan::beginPosition(motif) + nd,
-                          seqan::isParallel(motif),
+                          parallel,
                           seqan::getSequenceNo(motif),
                           seqan::isTFO(motif),
                           seqan::getMotif(motif)};
@@ -95,24 +239,28 @@ static void add_match(pato::motif_vector_t &motifs, pato::motif_t &motif,
 
 static void add_match(pato::motif_vector_t &motifs, pato::motif_t &motif,
                       unsigned start, unsigned end, unsigned errors,
+                      bool parallel,
                       [[maybe_unused]] const pato::mixed_motif_t &tag) {
-  add_match(motifs, motif, start, end, errors, pato::tfo_t());
+  add_match(motifs, motif, start, end, errors, parallel, pato::tfo_t());
 }
 
 static void add_match(pato::motif_vector_t &motifs, pato::motif_t &motif,
                       unsigned start, unsigned end, unsigned errors,
+                      bool parallel,
                       [[maybe_unused]] const pato::purine_motif_t &tag) {
-  add_match(motifs, motif, start, end, errors, pato::tfo_t());
+  add_match(motifs, motif, start, end, errors, parallel, pato::tfo_t());
 }
 
 static void add_match(pato::motif_vector_t &motifs, pato::motif_t &motif,
                       unsigned start, unsigned end, unsigned errors,
+                      bool parallel,
                       [[maybe_unused]] const pato::pyrimidine_motif_t &tag) {
-  add_match(motifs, motif, start, end, errors, pato::tfo_t());
+  add_match(motifs, motif, start, end, errors, parallel, pato::tfo_t());
 }
 
 static void add_match(pato::motif_vector_t &motifs, pato::motif_t &motif,
                       unsigned start, unsigned end, unsigned errors,
+                      [[maybe_unused]] bool parallel,
                       [[maybe_unused]] const pato::tts_t &tag) {
   auto motif_length = seqan::length(motif);
   auto st = seqan::getMotif(motif) == '+' ? start : motif_length - end;
@@ -130,90 +278,145 @@ static void add_match(pato::motif_vector_t &motifs, pato::motif_t &motif,
   motifs.push_back(std::move(tmp_motif));
 }
 
-template <typename string_t>
-static void encode_sequence(string_t &motif, char filter_char,
-                            char interrupt_char,
-                            pato::char_vector_vector_t &block_runs,
-                            pato::char_vector_vector_t &encoded_seq,
-                            unsigned min_block_run) {
-  if (encoded_seq.empty() || seqan::length(motif) > encoded_seq[0].size()) {
-    encoded_seq.clear();
-    encoded_seq.resize(3, pato::char_vector_t(seqan::length(motif) * 2, false));
-  } else {
-    encoded_seq[0].assign(seqan::length(motif), false);
-    encoded_seq[1].assign(seqan::length(motif), false);
-    encoded_seq[2].assign(seqan::length(motif), false);
-  }
+namespace {
 
-  unsigned counter = 0;
-  unsigned run_counter = 0;
+using single_block_run_t = seqan::Tag<struct _single_block_run>;
+using block_run_index_t = seqan::Tag<struct _block_run_index>;
 
-  for (auto m : motif) {
-    if (m == filter_char) {
-      encoded_seq[0][counter] = true;
-    } else if (m == interrupt_char) {
-      encoded_seq[1][counter] = true;
-      encoded_seq[2][counter] = true;
-
-      if (counter - run_counter >= min_block_run) {
-        for (unsigned i = 0; i <= counter - min_block_run; ++i) {
-          for (unsigned j = std::max(i, run_counter) + min_block_run;
-               j <= seqan::length(motif); ++j) {
-            block_runs[i][j] = true;
-          }
-        }
-      }
+} // namespace
 
-      run_counter = counter + 1;
-    } else {
-      encoded_seq[2][counter] = true;
-    }
-    ++counter;
+// With min_block_run == 1 any window whose last character is not an interrupt
+// already contains a block run, which the sliding window checks separately, so
+// there is nothing to encode nor to look up.
+template <typename view_t>
+static bool
+has_block_run([[maybe_unused]] const pato::index_vector_t &block_runs,
+              [[maybe_unused]] unsigned left, [[maybe_unused]] unsigned right,
+              [[maybe_unused]] unsigned motif_length,
+              [[maybe_unused]] const single_block_run_t &tag,
+              [[maybe_unused]] const view_t &view) {
+  return true;
+}
+
+static bool has_block_run(const pato::index_vector_t &block_runs,
+                          unsigned left, unsigned right,
+                          [[maybe_unused]] unsigned motif_length,
+                          [[maybe_unused]] const block_run_index_t &tag,
+                          [[maybe_unused]] const forward_view_t &view) {
+  return block_runs[left] <= right;
+}
+
+// The block runs inside the mirrored window [left, right) are those inside
+// [motif_length - right, motif_length - left) of the encoded sequence
+static bool has_block_run(const pato::index_vector_t &block_runs,
+                          unsigned left, unsigned right, unsigned motif_length,
+                          [[maybe_unused]] const block_run_index_t &tag,
+                          [[maybe_unused]] const mirrored_view_t &view) {
+  return block_runs[motif_length - right] <= motif_length - left;
+}
+
+static void
+encode_block_runs([[maybe_unused]] const pato::encoded_sequence_t &encoded_seq,
+                  [[maybe_unused]] pato::index_vector_t &block_runs,
+                  [[maybe_unused]] unsigned motif_length,
+                  [[maybe_unused]] unsigned min_block_run,
+                  [[maybe_unused]] const single_block_run_t &tag) {}
+
+// Marks, for every position i of the motif, the end of the first block run
+// (i.e., min_block_run consecutive non-interrupt characters) that starts at i
+// or later. A window [left, right) contains a block run iff the first such run
+// at or after left ends before right, which makes has_block_run an O(1) lookup
+// backed by an index that is linear in the length of the motif.
+static void encode_block_runs(const pato::encoded_sequence_t &encoded_seq,
+                              pato::index_vector_t &block_runs,
+                              unsigned motif_length, unsigned min_block_run,
+                              [[maybe_unused]] const block_run_index_t &tag) {
+  block_runs.resize(motif_length + 1);
+  block_runs[motif_length] = motif_length + 1;
+
+  unsigned run_length = 0;
+  for (unsigned i = motif_length; i > 0; --i) {
+    run_length =
+        is_bit_set(encoded_seq.interrupt_chars, i - 1) ? 0 : run_length + 1;
+    block_runs[i - 1] =
+        run_length >= min_block_run ? i - 1 + min_block_run : block_runs[i];
   }
+}
 
-  if (counter - run_counter >= min_block_run) {
-    for (unsigned i = 0; i <= counter - min_block_run; ++i) {
-      for (unsigned j = std::max(i, run_counter) + min_block_run;
-           j <= seqan::length(motif); ++j) {
-        block_runs[i][j] = true;
-      }
+static void reset_rank_vector(pato::rank_vector_t &bits, unsigned length) {
+  bits.words.assign(length / 64 + 1, 0);
+  bits.ranks.resize(length / 64 + 1);
+}
+
+static void update_ranks(pato::rank_vector_t &bits) {
+  unsigned rank = 0;
+  for (std::size_t i = 0; i < bits.words.size(); ++i) {
+    bits.ranks[i] = rank;
+    rank += seqan::popCount(bits.words[i]);
+  }
+}
+
+// Encodes the bits [begin, end) of words, which flag the characters of a
+// sequence, as a sequence of its own
+static void encode_bits(pato::rank_vector_t &bits,
+                        const pato::word_vector_t &words, unsigned begin,
+                        unsigned end) {
+  unsigned length = end - begin;
+  reset_rank_vector(bits, length);
+
+  for (unsigned i = 0; i < length; i += 64) {
+    unsigned word = (begin + i) >> 6;
+    unsigned shift = (begin + i) & 63;
+    uint64_t bits_word = words[word] >> shift;
+    if (shift != 0 && word + 1 < words.size()) {
+      bits_word |= words[word + 1] << (64 - shift);
     }
+    if (length - i < 64) {
+      bits_word &= (uint64_t{1} << (length - i)) - 1;
+    }
+    bits.words[i >> 6] = bits_word;
   }
+
+  update_ranks(bits);
 }
 
-namespace {
+template <typename string_t, typename block_run_tag_t>
+static void encode_sequence(string_t &motif, char filter_char,
+                            char interrupt_char,
+                            pato::index_vector_t &block_runs,
+                            pato::encoded_sequence_t &encoded_seq,
+                            unsigned min_block_run,
+                            const block_run_tag_t &block_run_tag) {
+  reset_rank_vector(encoded_seq.filter_chars, seqan::length(motif));
+  reset_rank_vector(encoded_seq.interrupt_chars, seqan::length(motif));
 
-template <typename pair_t> struct second_t {
-  typename pair_t::second_type operator()(const pair_t &p) const {
-    return p.second;
+  unsigned counter = 0;
+  for (auto m : motif) {
+    uint64_t bit = uint64_t{1} << (counter & 63);
+    if (m == filter_char) {
+      encoded_seq.filter_chars.words[counter >> 6] |= bit;
+    } else if (m == interrupt_char) {
+      encoded_seq.interrupt_chars.words[counter >> 6] |= bit;
+    }
+    ++counter;
   }
-};
 
-} // namespace
+  update_ranks(encoded_seq.filter_chars);
+  update_ranks(encoded_seq.interrupt_chars);
 
-template <typename map_t>
-static second_t<typename map_t::value_type>
-second([[maybe_unused]] const map_t &m) {
-  return second_t<typename map_t::value_type>{};
+  encode_block_runs(encoded_seq, block_runs, counter, min_block_run,
+                    block_run_tag);
 }
 
+// Merges the motifs that overlap, directly or through other motifs, into a
+// single motif spanning all of them. Sorting by begin position turns the
+// clusters of overlapping motifs into runs, which a single sweep closes as soon
+// as a motif starts at or after the furthest end seen so far. Each merged motif
+// keeps the attributes of the earliest motif of its cluster in the input, and
+// the output is sorted by begin position.
 static void reduce_motif_vector(pato::motif_vector_t &output,
-                                pato::motif_vector_t &input) {
-  using interval_value_t = seqan::Position<pato::motif_t>::Type;
-  using graph_t = seqan::Graph<seqan::Undirected<void>>;
-  using vertex_descriptor_t = seqan::VertexDescriptor<graph_t>::Type;
-  using interval_t =
-      seqan::IntervalAndCargo<interval_value_t, vertex_descriptor_t>;
-  using graph_size_t = typename seqan::Size<graph_t>::Type;
-  using interval_tree_t =
-      seqan::IntervalTree<interval_value_t, vertex_descriptor_t>;
-  using vertex_iterator_t =
-      seqan::Iterator<graph_t, seqan::VertexIterator>::Type;
-  using counts_t = seqan::String<vertex_descriptor_t>;
-  using component_t = seqan::String<graph_size_t>;
-  using prop_map_t = std::unordered_map<vertex_descriptor_t, pato::motif_t>;
-  using comp_map_t = std::unordered_map<graph_size_t, pato::motif_t>;
-
+                                pato::motif_vector_t &input,
+                                pato::index_vector_t &order) {
   if (input.empty()) {
     return;
   } else if (input.size() == 1) {
@@ -221,110 +424,77 @@ static void reduce_motif_vector(pato::motif_vector_t &output,
     return;
   }
 
-  graph_t parser;
-  prop_map_t prop_map;
-  std::vector<interval_t> intervals;
-
-  prop_map.reserve(input.size());
-  intervals.resize(input.size());
-
-  unsigned count = 0;
-  for (auto &motif : input) {
-    vertex_descriptor_t vtx = seqan::addVertex(parser);
-
-    intervals[count].i1 =
-        static_cast<interval_value_t>(seqan::beginPosition(motif));
-    intervals[count].i2 =
-        static_cast<interval_value_t>(seqan::endPosition(motif));
-    intervals[count].cargo = vtx;
-
-    prop_map.insert(std::make_pair(vtx, std::move(motif)));
-
-    ++count;
-  }
-
-  counts_t tree_results;
-  interval_tree_t tree(intervals);
-  vertex_iterator_t vertex_it(parser);
-  while (!seqan::atEnd(vertex_it)) {
-    auto &motif = prop_map.find(*vertex_it)->second;
-
-    seqan::findIntervals(tree_results, tree, seqan::beginPosition(motif),
-                         seqan::endPosition(motif));
-    for (auto &result : tree_results) {
-      if (*vertex_it == result) {
-        continue;
-      }
-      seqan::addEdge(parser, *vertex_it, result);
+  order.resize(input.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](unsigned i, unsigned j) -> bool {
+    auto begin_i = seqan::beginPosition(input[i]);
+    auto begin_j = seqan::beginPosition(input[j]);
+    return begin_i < begin_j || (begin_i == begin_j && i < j);
+  });
+
+  auto first = order.begin();
+  while (first != order.end()) {
+    unsigned representative = *first;
+    auto cluster_begin = seqan::beginPosition(input[*first]);
+    auto cluster_end = seqan::endPosition(input[*first]);
+
+    auto last = first + 1;
+    while (last != order.end() &&
+           seqan::beginPosition(input[*last]) < cluster_end) {
+      representative = std::min(representative, *last);
+      cluster_end = std::max(cluster_end, seqan::endPosition(input[*last]));
+      ++last;
     }
 
-    seqan::clear(tree_results);
-    ++vertex_it;
-  }
-
-  component_t components;
-  graph_size_t num_components = seqan::connectedComponents(components, parser);
-
-  comp_map_t comp_map;
-  comp_map.reserve(num_components);
-
-  seqan::goBegin(vertex_it);
-  while (!seqan::atEnd(vertex_it)) {
-    auto result_ptr = comp_map.find(seqan::getProperty(components, *vertex_it));
-
-    if (result_ptr != comp_map.end()) {
-      auto &motif = result_ptr->second;
-      merge(motif, prop_map.find(*vertex_it)->second);
-    } else {
-      auto &motif = prop_map.find(*vertex_it)->second;
-      comp_map.insert(std::make_pair(seqan::getProperty(components, *vertex_it),
-                                     std::move(motif)));
+    auto &motif = input[representative];
+    if (last - first > 1) {
+      seqan::setBeginPosition(motif, cluster_begin);
+      seqan::setEndPosition(motif, cluster_end);
     }
+    output.push_back(std::move(motif));
 
-    ++vertex_it;
+    first = last;
   }
-
-  output.reserve(output.size() + num_components);
-  std::transform(comp_map.begin(), comp_map.end(), std::back_inserter(output),
-                 second(comp_map));
 }
 
-template <typename tag_t>
-unsigned pato::filter_guanine_error_rate(motif_t &motif,
-                                         pato::guanine_filter_args_t &args,
-                                         const tag_t &tag,
-                                         const pato::options_t &opts) {
-  pato::motif_vector_t tmp_set;
-  pato::motif_vector_t &motifs_ref = args.reduce_set ? tmp_set : args.motifs;
-
-  // The following lines optimize memory usage and runtime performance in PATO
-  // by reusing allocated memory. Since this function is called frequently
-  // throughout the application, minimizing memory allocations and deallocations
-  // is crucial. By reusing the capacity already allocated for storing the
-  // encoded sequence, we reduce memory pressure and improve overall efficiency.
-  auto motif_length = seqan::length(motif);
-  if (args.block_runs.empty() ||
-      motif_length - opts.min_block_run + 1 > args.block_runs.size()) {
-    args.block_runs.clear();
-    args.block_runs.resize((motif_length - opts.min_block_run + 1) * 2,
-                           pato::char_vector_t((motif_length + 1) * 2, false));
-  } else {
-    for (unsigned i = 0; i < motif_length - opts.min_block_run + 1; i++) {
-      args.block_runs[i].assign(motif_length + 1, false);
-    }
-  }
-
+template <typename block_run_tag_t>
+static void encode_motif(pato::motif_t &motif,
+                         pato::guanine_filter_args_t &args,
+                         const block_run_tag_t &block_run_tag,
+                         const pato::options_t &opts) {
+  // The encoded sequence and the block run index live in the arguments so that
+  // their capacity is reused across calls: this function is called for every
+  // segment of every sequence and reallocating them each time would put
+  // unnecessary pressure on the allocator.
   char filter_char = args.filter_char;
   char interrupt_char = args.interrupt_char;
-  if (opts.min_guanine_rate <= 0.0) {
-    pato::filter_t filtered_sequence{motif};
-    filter_char = filter_char == 'G' ? 'R' : 'Y';
-    encode_sequence(filtered_sequence, filter_char, interrupt_char,
-                    args.block_runs, args.encoded_seq, opts.min_block_run);
-  } else {
-    encode_sequence(motif, filter_char, interrupt_char, args.block_runs,
-                    args.encoded_seq, opts.min_block_run);
-  }
+  seqan::visitMask(motif, [&](auto &mask) {
+    if (opts.min_guanine_rate <= 0.0) {
+      using mask_t = std::remove_reference_t<decltype(mask)>;
+      seqan::ModifiedString<mask_t, seqan::ModView<seqan::FunctorRYFilter>>
+          filtered_sequence{mask};
+      encode_sequence(filtered_sequence, filter_char == 'G' ? 'R' : 'Y',
+                      interrupt_char, args.block_runs, args.encoded_seq,
+                      opts.min_block_run, block_run_tag);
+    } else {
+      encode_sequence(mask, filter_char, interrupt_char, args.block_runs,
+                      args.encoded_seq, opts.min_block_run, block_run_tag);
+    }
+  });
+}
+
+// Slides the window over an encoded sequence of the given length as seen
+// through the view, and passes the bounds and the errors of every match to
+// add_window.
+template <typename tag_t, typename block_run_tag_t, typename view_t,
+          typename function_t>
+static unsigned sweep_windows(std::size_t motif_length,
+                              pato::guanine_filter_args_t &args,
+                              const tag_t &tag,
+                              const block_run_tag_t &block_run_tag,
+                              const view_t &view, const pato::options_t &opts,
+                              function_t &&add_window) {
+  const auto &encoded_seq = args.encoded_seq;
 
   double max_error = std::floor(motif_length * opts.error_rate);
   double max_tolerated =
@@ -333,15 +503,15 @@ unsigned pato::filter_guanine_error_rate(motif_t &motif,
     max_error = std::min(max_error, static_cast<double>(opts.maximal_error));
   }
 
-  unsigned filter_chars = 0;
-  unsigned interrupt_chars = 0;
-  unsigned non_filter_chars = 0;
-
   unsigned max_length = motif_length;
   if (opts.max_length >= opts.min_length) {
     max_length = static_cast<unsigned>(opts.max_length);
   }
 
+  const pato::window_bounds_t &bounds = args.window_bounds;
+  update_window_bounds(args.window_bounds,
+                       std::min<std::size_t>(max_length, motif_length), opts);
+
   unsigned tmp_start = 0;
   unsigned tmp_end = 0;
   unsigned tmp_errors = 0;
@@ -351,34 +521,36 @@ unsigned pato::filter_guanine_error_rate(motif_t &motif,
   unsigned right = 0;
 
   unsigned matches = 0;
-  while (args.block_runs[left][motif_length] &&
+  while (has_block_run(args.block_runs, left, motif_length, motif_length,
+                       block_run_tag, view) &&
          left + opts.min_length <= motif_length) {
     while (static_cast<int>(right - left) < opts.min_length &&
            right < motif_length) {
-      while (static_cast<int>(right - left) < opts.min_length &&
-             right < motif_length) {
-        increase_right(args.encoded_seq, right, filter_chars, interrupt_chars,
-                       non_filter_chars);
-      }
+      right = std::min<std::size_t>(left + opts.min_length, motif_length);
+
+      unsigned interrupt_chars = count_chars(
+          encoded_seq.interrupt_chars, left, right, motif_length, view);
       while (interrupt_chars > max_error) {
-        increase_left(args.encoded_seq, left, filter_chars, interrupt_chars,
-                      non_filter_chars);
+        interrupt_chars -=
+            is_interrupt_char(encoded_seq, left, motif_length, view);
+        ++left;
       }
+      unsigned non_filter_chars =
+          right - left -
+          count_chars(encoded_seq.filter_chars, left, right, motif_length,
+                      view);
       while (non_filter_chars > max_tolerated) {
-        increase_left(args.encoded_seq, left, filter_chars, interrupt_chars,
-                      non_filter_chars);
+        non_filter_chars -=
+            !is_filter_char(encoded_seq, left, motif_length, view);
+        ++left;
       }
-      while (left < motif_length && is_interrupt_char(args.encoded_seq, left)) {
-        increase_left(args.encoded_seq, left, filter_chars, interrupt_chars,
-                      non_filter_chars);
+      while (left < motif_length &&
+             is_interrupt_char(encoded_seq, left, motif_length, view)) {
+        ++left;
       }
 
       if (right < left) {
         right = left;
-
-        filter_chars = 0;
-        interrupt_chars = 0;
-        non_filter_chars = 0;
       }
     }
 
@@ -388,19 +560,38 @@ unsigned pato::filter_guanine_error_rate(motif_t &motif,
 
     bool is_match = false;
 
-    while (interrupt_chars <= max_error && non_filter_chars <= max_tolerated &&
-           right - left <= max_length) {
-      double filter_chars_rate =
-          static_cast<double>(filter_chars) / (right - left);
-      double interrupt_chars_rate =
-          static_cast<double>(interrupt_chars) / (right - left);
-
-      if (args.block_runs[left][right] &&
-          !is_interrupt_char(args.encoded_seq, right - 1) &&
-          interrupt_chars_rate <= opts.error_rate &&
-          opts.min_guanine_rate <= filter_chars_rate &&
-          filter_chars_rate <= opts.max_guanine_rate &&
-          motif_specific_constraint(filter_chars_rate, args.ornt, tag, opts)) {
+    // The ranks at left stay fixed while the window grows to the right
+    unsigned left_filter_rank =
+        rank_at(encoded_seq.filter_chars, left, motif_length, view);
+    unsigned left_interrupt_rank =
+        rank_at(encoded_seq.interrupt_chars, left, motif_length, view);
+
+    while (true) {
+      unsigned filter_chars = count_between(
+          left_filter_rank,
+          rank_at(encoded_seq.filter_chars, right, motif_length, view), view);
+      unsigned interrupt_chars = count_between(
+          left_interrupt_rank,
+          rank_at(encoded_seq.interrupt_chars, right, motif_length, view),
+          view);
+      unsigned non_filter_chars = right - left - filter_chars;
+
+      if (interrupt_chars > max_error || non_filter_chars > max_tolerated ||
+          right - left > max_length) {
+        break;
+      }
+
+      auto window_length = right - left;
+      auto filter_count = static_cast<int>(filter_chars);
+      if (has_block_run(args.block_runs, left, right, motif_length,
+                        block_run_tag, view) &&
+          !is_interrupt_char(encoded_seq, right - 1, motif_length, view) &&
+          static_cast<int>(interrupt_chars) <=
+              bounds.max_interrupt_chars[window_length] &&
+          bounds.min_filter_chars[window_length] <= filter_count &&
+          filter_count <= bounds.max_filter_chars[window_length] &&
+          motif_specific_constraint(filter_count, window_length, args.ornt,
+                                    bounds, tag)) {
         is_match = true;
         ++matches;
 
@@ -411,13 +602,12 @@ unsigned pato::filter_guanine_error_rate(motif_t &motif,
         if (opts.all_matches) {
           covered_end = tmp_end;
           is_match = false;
-          add_match(motifs_ref, motif, tmp_start, tmp_end, tmp_errors, tag);
+          add_window(tmp_start, tmp_end, tmp_errors);
         }
       }
 
       if (right < motif_length) {
-        increase_right(args.encoded_seq, right, filter_chars, interrupt_chars,
-                       non_filter_chars);
+        ++right;
       } else {
         break;
       }
@@ -425,28 +615,141 @@ unsigned pato::filter_guanine_error_rate(motif_t &motif,
 
     if (is_match && tmp_end > covered_end) {
       covered_end = tmp_end;
-      add_match(motifs_ref, motif, tmp_start, tmp_end, tmp_errors, tag);
+      add_window(tmp_start, tmp_end, tmp_errors);
     }
 
     ++left;
-    while (left < motif_length && is_interrupt_char(args.encoded_seq, left)) {
+    while (left < motif_length &&
+           is_interrupt_char(encoded_seq, left, motif_length, view)) {
       ++left;
     }
 
     right = left;
-
-    filter_chars = 0;
-    interrupt_chars = 0;
-    non_filter_chars = 0;
   }
 
+  return matches;
+}
+
+// Slides the window over the encoded motif as seen through the view, which
+// must have been encoded beforehand.
+template <typename tag_t, typename block_run_tag_t, typename view_t>
+static unsigned sweep_motif(pato::motif_t &motif,
+                            pato::guanine_filter_args_t &args, const tag_t &tag,
+                            const block_run_tag_t &block_run_tag,
+                            const view_t &view, const pato::options_t &opts) {
+  pato::motif_vector_t &motifs_ref =
+      args.reduce_set ? args.tmp_motifs : args.motifs;
+
+  bool parallel = is_parallel(motif, view);
+  unsigned matches = sweep_windows(
+      seqan::length(motif), args, tag, block_run_tag, view, opts,
+      [&](unsigned start, unsigned end, unsigned errors) {
+        add_match(motifs_ref, motif, start, end, errors, parallel, tag);
+      });
+
   if (args.reduce_set) {
-    reduce_motif_vector(args.motifs, motifs_ref);
+    reduce_motif_vector(args.motifs, motifs_ref, args.merge_order);
+    motifs_ref.clear();
   }
 
   return matches;
 }
 
+template <typename tag_t, typename block_run_tag_t>
+static unsigned filter_guanine_error_rate(pato::motif_t &motif,
+                                          pato::guanine_filter_args_t &args,
+                                          const tag_t &tag,
+                                          const block_run_tag_t &block_run_tag,
+                                          const pato::options_t &opts) {
+  encode_motif(motif, args, block_run_tag, opts);
+  return sweep_motif(motif, args, tag, block_run_tag, forward_view_t{}, opts);
+}
+
+// The antiparallel motif of a mixed segment is the reverse of the parallel
+// one, so a single encoding serves both orientations: the antiparallel matches
+// come from sweeping it mirrored.
+template <typename block_run_tag_t>
+static unsigned filter_guanine_error_rate(pato::motif_t &motif,
+                                          pato::guanine_filter_args_t &args,
+                                          bool parallel, bool antiparallel,
+                                          const block_run_tag_t &block_run_tag,
+                                          const pato::options_t &opts) {
+  encode_motif(motif, args, block_run_tag, opts);
+
+  unsigned matches = 0;
+  if (parallel) {
+    matches += sweep_motif(motif, args, pato::mixed_motif_t{}, block_run_tag,
+                           forward_view_t{}, opts);
+  }
+  if (antiparallel) {
+    matches += sweep_motif(motif, args, pato::mixed_motif_t{}, block_run_tag,
+                           mirrored_view_t{}, opts);
+  }
+  return matches;
+}
+
+template <typename block_run_tag_t>
+static unsigned filter_guanine_error_rate(
+    const pato::word_vector_t &filter_chars,
+    const pato::word_vector_t &interrupt_chars, const pato::interval_t &segment,
+    pato::guanine_filter_args_t &args, pato::interval_vector_t &windows,
+    const block_run_tag_t &block_run_tag, const pato::options_t &opts) {
+  unsigned length = segment.second - segment.first;
+  encode_bits(args.encoded_seq.filter_chars, filter_chars, segment.first,
+              segment.second);
+  encode_bits(args.encoded_seq.interrupt_chars, interrupt_chars, segment.first,
+              segment.second);
+  encode_block_runs(args.encoded_seq, args.block_runs, length,
+                    opts.min_block_run, block_run_tag);
+
+  return sweep_windows(length, args, pato::tts_t{}, block_run_tag,
+                       forward_view_t{}, opts,
+                       [&](unsigned start, unsigned end, unsigned) {
+                         windows.emplace_back(segment.first + start,
+                                              segment.first + end);
+                       });
+}
+
+template <typename tag_t>
+unsigned pato::filter_guanine_error_rate(motif_t &motif,
+                                         pato::guanine_filter_args_t &args,
+                                         const tag_t &tag,
+                                         const pato::options_t &opts) {
+  if (opts.min_block_run == 1) {
+    return ::filter_guanine_error_rate(motif, args, tag, single_block_run_t{},
+                                       opts);
+  }
+  return ::filter_guanine_error_rate(motif, args, tag, block_run_index_t{},
+                                     opts);
+}
+
+unsigned pato::filter_guanine_error_rate(motif_t &motif,
+                                         pato::guanine_filter_args_t &args,
+                                         bool parallel, bool antiparallel,
+                                         const pato::options_t &opts) {
+  if (opts.min_block_run == 1) {
+    return ::filter_guanine_error_rate(motif, args, parallel, antiparallel,
+                                       single_block_run_t{}, opts);
+  }
+  return ::filter_guanine_error_rate(motif, args, parallel, antiparallel,
+                                     block_run_index_t{}, opts);
+}
+
+unsigned pato::filter_guanine_error_rate(const word_vector_t &filter_chars,
+                                         const word_vector_t &interrupt_chars,
+                                         const interval_t &segment,
+                                         pato::guanine_filter_args_t &args,
+                                         interval_vector_t &windows,
+                                         const pato::options_t &opts) {
+  if (opts.min_block_run == 1) {
+    return ::filter_guanine_error_rate(filter_chars, interrupt_chars, segment,
+                                       args, windows, single_block_run_t{},
+                                       opts);
+  }
+  return ::filter_guanine_error_rate(filter_chars, interrupt_chars, segment,
+                                     args, windows, block_run_index_t{}, opts);
+}
+
 template unsigned pato::filter_guanine_error_rate<pato::tts_t>(
     motif_t &motif, pato::guanine_filter_args_t &args, const pato::tts_t &tag,
     const pato::options_t &opts);
@@ -35,11 +35,35 @@ enum class orientation_t : int {
   parallel = 1,
 };
 
+// A bit-packed flag per character together with the number of flags set
+// before each word, so that the flags set in any range take two lookups.
+struct rank_vector_t {
+  word_vector_t words;
+  index_vector_t ranks;
+};
+
+struct encoded_sequence_t {
+  rank_vector_t filter_chars;
+  rank_vector_t interrupt_chars;
+};
+
+// Integer bounds on the number of interrupt and filter characters of a window,
+// indexed by its length. They are derived once from the rates in options_t so
+// that the sliding window only compares counts.
+struct window_bounds_t {
+  std::vector<int> max_interrupt_chars;
+  std::vector<int> min_filter_chars;
+  std::vector<int> max_filter_chars;
+  std::vector<int> min_antiparallel_filter_chars;
+  std::vector<int> max_parallel_filter_chars;
+};
+
 struct guanine_filter_args_t {
   motif_vector_t &motifs;
 
-  char_vector_vector_t &block_runs;
-  char_vector_vector_t &encoded_seq;
+  index_vector_t &block_runs;
+  encoded_sequence_t &encoded_seq;
+  window_bounds_t &window_bounds;
 
   bool reduce_set;
 
@@ -48,13 +72,19 @@ struct guanine_filter_args_t {
 
   orientation_t ornt;
 
+  // Scratch space for merging overlapping motifs, kept across calls so that
+  // its capacity is reused
+  motif_vector_t tmp_motifs;
+  index_vector_t merge_order;
+
   guanine_filter_args_t(motif_vector_t &motifs_,
-                        char_vector_vector_t &block_runs_,
-                        char_vector_vector_t &encoded_seq_, bool reduce_set_,
+                        index_vector_t &block_runs_,
+                        encoded_sequence_t &encoded_seq_,
+                        window_bounds_t &window_bounds_, bool reduce_set_,
                         char filter_char_, char interrupt_char_)
       : motifs{motifs_}, block_runs{block_runs_}, encoded_seq{encoded_seq_},
-        reduce_set{reduce_set_}, filter_char{filter_char_},
-        interrupt_char{interrupt_char_} {}
+        window_bounds{window_bounds_}, reduce_set{reduce_set_},
+        filter_char{filter_char_}, interrupt_char{interrupt_char_} {}
 };
 
 using tts_t = seqan::Tag<struct _tts>;
@@ -67,6 +97,22 @@ template <typename tag_t>
 unsigned filter_guanine_error_rate(motif_t &motif, guanine_filter_args_t &args,
                                    const tag_t &tag, const options_t &opts);
 
+// Filters a parallel mixed motif and, if requested, its antiparallel
+// counterpart, encoding the segment only once.
+unsigned filter_guanine_error_rate(motif_t &motif, guanine_filter_args_t &args,
+                                   bool parallel, bool antiparallel,
+                                   const options_t &opts);
+
+// Filters the segment of a TTS whose filter and interrupt characters are
+// flagged by bits rather than stored in a string, and appends the bounds of
+// the matches to windows.
+unsigned filter_guanine_error_rate(const word_vector_t &filter_chars,
+                                   const word_vector_t &interrupt_chars,
+                                   const interval_t &segment,
+                                   guanine_filter_args_t &args,
+                                   interval_vector_t &windows,
+                                   const options_t &opts);
+
 } // namespace pato
 
 #endif // PATO_LIB_GUANINE_FILTER_H
@@ -0,0 +1,77 @@
+// MIT License
+//
+// Copyright (c) 2022-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "match_queue.h"
+
+pato::match_queue_t::match_queue_t(std::size_t capacity_)
+    : capacity{capacity_}, closed{false} {}
+
+void pato::match_queue_t::push(pato::match_vector_t &block) {
+  std::unique_lock<std::mutex> lock{mutex};
+  not_full.wait(lock, [this] { return blocks.size() < capacity; });
+
+  blocks.push_back(std::move(block));
+  block.clear();
+  if (!free_blocks.empty()) {
+    block.swap(free_blocks.back());
+    free_blocks.pop_back();
+  }
+
+  lock.unlock();
+  not_empty.notify_one();
+}
+
+bool pato::match_queue_t::pop(pato::match_vector_t &block) {
+  std::unique_lock<std::mutex> lock{mutex};
+  not_empty.wait(lock, [this] { return !blocks.empty() || closed; });
+  if (blocks.empty()) {
+    return false;
+  }
+
+  block.swap(blocks.front());
+  blocks.pop_front();
+
+  lock.unlock();
+  not_full.notify_one();
+  return true;
+}
+
+void pato::match_queue_t::recycle(pato::match_vector_t &block) {
+  block.clear();
+
+  std::lock_guard<std::mutex> lock{mutex};
+  free_blocks.push_back(std::move(block));
+  block = pato::match_vector_t{};
+}
+
+void pato::match_queue_t::open() {
+  std::lock_guard<std::mutex> lock{mutex};
+  closed = false;
+}
+
+void pato::match_queue_t::close() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    closed = true;
+  }
+  not_empty.notify_all();
+}
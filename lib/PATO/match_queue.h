@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2022-onwards Iñaki Amatria-Barral
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PATO_LIB_MATCH_QUEUE_H
+#define PATO_LIB_MATCH_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "types.h"
+
+namespace pato {
+
+// Bounded queue of blocks of matches. The TPX workers push the blocks they
+// fill and the writer thread pops and prints them, so no more than capacity
+// blocks are ever waiting to be written. Printed blocks are recycled to keep
+// their storage.
+class match_queue_t {
+public:
+  explicit match_queue_t(std::size_t capacity_);
+
+  // Hands the block over, waiting for room if needed, and leaves an empty
+  // block in its place
+  void push(match_vector_t &block);
+  // Waits for a block to print; false once the queue is closed and drained
+  bool pop(match_vector_t &block);
+  void recycle(match_vector_t &block);
+
+  void open();
+  void close();
+
+private:
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+
+  std::deque<match_vector_t> blocks;
+  std::vector<match_vector_t> free_blocks;
+
+  std::size_t capacity;
+  bool closed;
+};
+
+} // namespace pato
+
+#endif // PATO_LIB_MATCH_QUEUE_H
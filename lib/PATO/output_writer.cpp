@@ -94,14 +94,25 @@ pato::output_writer_t::output_writer_t(std::FILE *output_file_,
                                        std::FILE *summary_file_,
                                        const options_t &opts_)
     : output_file{output_file_,
-                  [this](std::FILE *f) -> void {
-                    if (opts.output_format != output_format_t::summary) {
+                  [output_format = opts_.output_format](std::FILE *f) -> void {
+                    if (output_format != output_format_t::summary) {
                       std::fclose(f);
                     }
                   }},
       summary_file{summary_file_, [](std::FILE *f) -> void { std::fclose(f); }},
       opts{opts_} {}
 
+// Sequence names are printed by several threads at once, so they are printed
+// as "%.*s" rather than through toCString, which appends a terminator to the
+// name and may even reallocate it
+static int name_length(const seqan::CharString &name) {
+  return static_cast<int>(seqan::length(name));
+}
+
+static const char *name_chars(const seqan::CharString &name) {
+  return seqan::begin(name, seqan::Standard());
+}
+
 void pato::output_writer_t::print_motifs(const pato::motif_vector_t &motifs,
                                          const pato::name_vector_t &names) {
   if (opts.output_format == output_format_t::summary || motifs.empty()) {
@@ -114,8 +125,9 @@ void pato::output_writer_t::print_motifs(const pato::motif_vector_t &motifs,
   for (const auto &m : motifs) {
     if (opts.output_format == output_format_t::bed) {
       std::fprintf(output_file.get(),
-                   "%s\t%lu\t%lu\t%u\t%c\t%.2g\t%s\t%.2g\t%d\t%s\t-\n",
-                   seqan::toCString(names[seqan::getSequenceNo(m)]),
+                   "%.*s\t%lu\t%lu\t%u\t%c\t%.2g\t%s\t%.2g\t%d\t%s\t-\n",
+                   name_length(names[seqan::getSequenceNo(m)]),
+                   name_chars(names[seqan::getSequenceNo(m)]),
                    seqan::beginPosition(m), seqan::endPosition(m),
                    seqan::score(m), seqan::getMotif(m),
                    1.0 - static_cast<double>(seqan::score(m)) /
@@ -132,8 +144,9 @@ void pato::output_writer_t::print_motifs(const pato::motif_vector_t &motifs,
       }
 
       std::fprintf(
-          output_file.get(), ">%s_%u\t%lu-%lu %c\t%u\t%s\t%g\t%d\t-\n%s\n",
-          seqan::toCString(names[seqan::getSequenceNo(m)]), counter++,
+          output_file.get(), ">%.*s_%u\t%lu-%lu %c\t%u\t%s\t%g\t%d\t-\n%s\n",
+          name_length(names[seqan::getSequenceNo(m)]),
+          name_chars(names[seqan::getSequenceNo(m)]), counter++,
           seqan::beginPosition(m), seqan::endPosition(m), seqan::getMotif(m),
           seqan::score(m), seqan::toCString(seqan::errorString(m)),
           seqan::guanineRate(m), seqan::duplicates(m),
@@ -167,6 +180,9 @@ triplex_alignment_string(const pato::match_t &match,
   seqan::CharString tfo_ps = seqan::prettyString(tfo_motif);
   seqan::CharString tts_ps = seqan::prettyString(tts_motif);
 
+  pato::triplex_t tfo_mask = seqan::ttsString(tfo_motif);
+  pato::triplex_t tts_mask = seqan::ttsString(tts_motif);
+
   seqan::CharString opp{tts_ps};
   seqan::complement(opp);
 
@@ -178,10 +194,10 @@ triplex_alignment_string(const pato::match_t &match,
     alignment << "TTS: 3'- " << tts_ps << " -5'\n";
     alignment << "         ";
 
-    auto tts_it = seqan::begin(tts_motif);
-    auto tts_end = seqan::end(tts_motif);
-    auto tfo_it = seqan::begin(tfo_motif);
-    auto tfo_end = seqan::end(tfo_motif);
+    auto tts_it = seqan::begin(tts_mask);
+    auto tts_end = seqan::end(tts_mask);
+    auto tfo_it = seqan::begin(tfo_mask);
+    auto tfo_end = seqan::end(tfo_mask);
     while (tts_end != tts_it && tfo_end != tfo_it) {
       --tts_end;
       --tfo_end;
@@ -208,10 +224,10 @@ triplex_alignment_string(const pato::match_t &match,
     }
     alignment << "         ";
 
-    auto tts_it = seqan::begin(tts_motif);
-    auto tts_end = seqan::end(tts_motif);
-    auto tfo_it = seqan::begin(tfo_motif);
-    auto tfo_end = seqan::end(tfo_motif);
+    auto tts_it = seqan::begin(tts_mask);
+    auto tts_end = seqan::end(tts_mask);
+    auto tfo_it = seqan::begin(tfo_mask);
+    auto tfo_end = seqan::end(tfo_mask);
     while (tts_it != tts_end && tfo_it != tfo_end) {
       if (*tts_it == *tfo_it) {
         alignment << "|";
@@ -253,6 +269,9 @@ static seqan::CharString triplex_error_string(
   seqan::CharString tfo_ps = seqan::prettyString(tfo_motif);
   seqan::CharString tts_ps = seqan::prettyString(tts_motif);
 
+  pato::triplex_t tfo_mask = seqan::ttsString(tfo_motif);
+  pato::triplex_t tts_mask = seqan::ttsString(tts_motif);
+
   if (opts.error_reference == pato::error_reference_t::purine_strand) {
     if (!tfo_motifs[match.tfoNo].parallel) {
       seqan::reverse(tfo_ps);
@@ -274,10 +293,10 @@ static seqan::CharString triplex_error_string(
     }
   }
 
-  auto tts_it = seqan::begin(tts_motif);
-  auto tts_end = seqan::end(tts_motif);
-  auto tfo_it = seqan::begin(tfo_motif);
-  auto tfo_end = seqan::end(tfo_motif);
+  auto tts_it = seqan::begin(tts_mask);
+  auto tts_end = seqan::end(tts_mask);
+  auto tfo_it = seqan::begin(tfo_mask);
+  auto tfo_end = seqan::end(tfo_mask);
   unsigned i = 0;
 
   if (opts.error_reference == pato::error_reference_t::purine_strand ||
@@ -330,8 +349,9 @@ void pato::output_writer_t::print_motifs_summary(
     const pato::name_vector_t &names) {
   for (const auto &potential : potentials) {
     if (seqan::hasCount(potential)) {
-      std::fprintf(summary_file.get(), "%s\t%u\t%.3g",
-                   seqan::toCString(names[seqan::getKey(potential)]),
+      std::fprintf(summary_file.get(), "%.*s\t%u\t%.3g",
+                   name_length(names[seqan::getKey(potential)]),
+                   name_chars(names[seqan::getKey(potential)]),
                    seqan::getCounts(potential),
                    seqan::getCounts(potential) / seqan::getNorm(potential));
       if (opts.run_mode == run_mode_t::tfo_search) {
@@ -350,35 +370,24 @@ void pato::output_writer_t::print_motifs_summary(
 }
 
 void pato::output_writer_t::print_triplexes(
-#if !defined(_OPENMP)
     const pato::match_vector_t &matches, const pato::motif_vector_t &tfo_motifs,
     const pato::name_vector_t &tfo_names,
-    const pato::motif_vector_t &tts_motifs, const pato::name_vector_t &tts_names
-#else
-    const pato::match_vector_vector_t &matches,
-    const pato::motif_vector_t &tfo_motifs,
-    const pato::name_vector_t &tfo_names,
-    const pato::motif_vector_t &tts_motifs, const pato::name_vector_t &tts_names
-#endif
-) {
+    const pato::motif_vector_t &tts_motifs,
+    const pato::name_vector_t &tts_names) {
   if (opts.output_format == output_format_t::summary) {
     return;
   }
 
-#if !defined(_OPENMP)
   for (const auto &match : matches) {
-#else
-  for (const auto &local_matches : matches) {
-    for (const auto &match : local_matches) {
-#endif
     auto tfo_seq_id = tfo_motifs[match.tfoNo].seqNo;
     auto tts_seq_id = match.ttsSeqNo;
 
     std::fprintf(
         output_file.get(),
-        "%s\t%lu\t%lu\t%s\t%lu\t%lu\t%u\t%.2g\t%s\t%c\t%c\t%c\t%.2g",
-        seqan::toCString(tfo_names[tfo_seq_id]), match.oBegin, match.oEnd,
-        seqan::toCString(tts_names[tts_seq_id]), match.dBegin, match.dEnd,
+        "%.*s\t%lu\t%lu\t%.*s\t%lu\t%lu\t%u\t%.2g\t%s\t%c\t%c\t%c\t%.2g",
+        name_length(tfo_names[tfo_seq_id]), name_chars(tfo_names[tfo_seq_id]),
+        match.oBegin, match.oEnd, name_length(tts_names[tts_seq_id]),
+        name_chars(tts_names[tts_seq_id]), match.dBegin, match.dEnd,
         match.mScore,
         1.0 - static_cast<double>(match.mScore) / (match.dEnd - match.dBegin),
         seqan::toCString(
@@ -391,23 +400,21 @@ void pato::output_writer_t::print_triplexes(
                                                              tts_motifs)));
     }
     std::fprintf(output_file.get(), "\n");
-#if defined(_OPENMP)
   }
-#endif
-}
 }
 
 void pato::output_writer_t::print_triplex_summary(
-    const pato::potential_map_t &potentials,
+    const pato::potential_vector_t &potentials,
     const pato::name_vector_t &tfo_names,
     const pato::name_vector_t &tts_names) {
-  for (const auto &potential_entry : potentials) {
-    const auto &potential = potential_entry.second;
+  for (const auto &potential : potentials) {
     if (seqan::hasCount(potential)) {
       std::fprintf(summary_file.get(),
-                   "%s\t%s\t%u\t%.3g\t%u\t%.3g\t%u\t%.3g\t%u\t%.3g\t\n",
-                   seqan::toCString(tts_names[seqan::getKey(potential).second]),
-                   seqan::toCString(tfo_names[seqan::getKey(potential).first]),
+                   "%.*s\t%.*s\t%u\t%.3g\t%u\t%.3g\t%u\t%.3g\t%u\t%.3g\t\n",
+                   name_length(tts_names[seqan::getKey(potential).second]),
+                   name_chars(tts_names[seqan::getKey(potential).second]),
+                   name_length(tfo_names[seqan::getKey(potential).first]),
+                   name_chars(tfo_names[seqan::getKey(potential).first]),
                    seqan::getCounts(potential),
                    seqan::getCounts(potential) / seqan::getNorm(potential),
                    seqan::getCount(potential, 'R'),
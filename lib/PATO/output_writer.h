@@ -38,18 +38,12 @@ public:
   void print_motifs(const motif_vector_t &motifs, const name_vector_t &names);
   void print_motifs_summary(const motif_potential_vector_t &potentials,
                             const name_vector_t &names);
-  void print_triplexes(
-#if !defined(_OPENMP)
-      const match_vector_t &matches, const motif_vector_t &tfo_motifs,
-      const name_vector_t &tfo_names, const motif_vector_t &tts_motifs,
-      const name_vector_t &tts_names
-#else
-      const match_vector_vector_t &matches, const motif_vector_t &tfo_motifs,
-      const name_vector_t &tfo_names, const motif_vector_t &tts_motifs,
-      const name_vector_t &tts_names
-#endif
-  );
-  void print_triplex_summary(const potential_map_t &potentials,
+  void print_triplexes(const match_vector_t &matches,
+                       const motif_vector_t &tfo_motifs,
+                       const name_vector_t &tfo_names,
+                       const motif_vector_t &tts_motifs,
+                       const name_vector_t &tts_names);
+  void print_triplex_summary(const potential_vector_t &potentials,
                              const name_vector_t &tfo_names,
                              const name_vector_t &tts_names);
 
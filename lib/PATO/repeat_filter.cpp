@@ -22,11 +22,149 @@
 
 #include "repeat_filter.h"
 
+#include <algorithm>
+#include <array>
+#include <map>
+
+namespace {
+
+using repeat_index_t =
+    seqan::Index<pato::triplex_t, seqan::IndexWotd<seqan::TRepeatFinder>>;
+using repeat_iterator_t =
+    seqan::Iterator<repeat_index_t,
+                    seqan::TopDown<seqan::ParentLinks<>>>::Type;
+
+} // namespace
+
 void pato::filter_repeats(pato::repeat_vector_t &repeats,
                           pato::triplex_t &sequence, unsigned min_repeat_length,
                           unsigned max_repeat_period) {
   seqan::findRepeats(repeats, sequence, min_repeat_length, max_repeat_period);
-  for (auto &repeat : repeats) {
+  pato::mask_repeats(sequence, repeats);
+}
+
+// Period-1 repeats are found by seqan with a single scan instead of a suffix
+// tree, so such a search is never split
+unsigned pato::count_repeat_subtrees(const pato::triplex_t &sequence,
+                                     unsigned max_repeat_period) {
+  if (max_repeat_period < 2) {
+    return 1;
+  }
+
+  std::array<bool, seqan::ValueSize<seqan::Triplex>::VALUE> present{};
+  for (auto c : sequence) {
+    present[seqan::ordValue(c)] = true;
+  }
+  auto num_subtrees = static_cast<unsigned>(
+      std::count(present.begin(), present.end(), true));
+  return std::max(num_subtrees, 1u);
+}
+
+// Reports a run of occurrences of a node of the suffix tree as a repeat like
+// seqan::findRepeats does: if it is long enough, and its period is longer
+// than the parent node but no longer than the node itself
+template <typename iterator_t>
+static void add_repeat(std::map<unsigned, pato::repeat_t> &repeats,
+                       const repeat_iterator_t &node, iterator_t first,
+                       iterator_t last, std::size_t period,
+                       std::size_t repeat_length, std::size_t min_length) {
+  if (repeat_length >= min_length && seqan::parentRepLength(node) < period &&
+      period <= seqan::repLength(node)) {
+    pato::repeat_t repeat;
+    repeat.beginPosition = *first;
+    repeat.endPosition = *last + period;
+    repeat.period = period;
+    repeats.insert({repeat.beginPosition, repeat});
+  }
+}
+
+// Walks the subtree in the same order as seqan::findRepeats, so that the first
+// repeat found at a position is the one kept. No other subtree finds repeats
+// at the positions of this one.
+static void find_subtree_repeats(std::map<unsigned, pato::repeat_t> &found,
+                                 repeat_iterator_t node,
+                                 unsigned min_repeat_length) {
+  auto range = seqan::value(node).range;
+  for (; !seqan::atEnd(node) && !seqan::isRoot(node) &&
+         seqan::value(node).range.i1 >= range.i1 &&
+         seqan::value(node).range.i2 <= range.i2;
+       seqan::goNext(node)) {
+    std::size_t rep_length = seqan::repLength(node);
+    if (min_repeat_length <= rep_length) {
+      continue;
+    }
+    std::size_t min_length = min_repeat_length - rep_length;
+
+    auto occurrences = seqan::getOccurrences(node);
+    auto first = seqan::begin(occurrences, seqan::Standard());
+    auto last = first;
+    auto end = seqan::end(occurrences, seqan::Standard());
+
+    std::size_t period = 0;
+    std::size_t repeat_length = 0;
+    for (auto next = first + 1; next < end; ++next) {
+      std::size_t diff = *next - *last;
+      if (diff != period) {
+        add_repeat(found, node, first, last, period, repeat_length,
+                   min_length);
+        first = last;
+        period = diff;
+        repeat_length = 0;
+      }
+      repeat_length += period;
+      last = next;
+    }
+    add_repeat(found, node, first, last, period, repeat_length, min_length);
+  }
+}
+
+// A single suffix tree serves every subtree of the range
+bool pato::find_repeats(pato::repeat_vector_t &repeats,
+                        const pato::triplex_t &sequence, unsigned first_subtree,
+                        unsigned last_subtree, unsigned min_repeat_length,
+                        unsigned max_repeat_period) {
+  repeats.clear();
+  if (max_repeat_period < 2) {
+    if (first_subtree > 0) {
+      return false;
+    }
+    seqan::findRepeats(repeats, sequence, min_repeat_length,
+                       max_repeat_period);
+    return true;
+  }
+
+  repeat_index_t index{sequence};
+  seqan::cargo(index).minRepeatLen = min_repeat_length;
+  seqan::cargo(index).maxPeriod = max_repeat_period;
+
+  repeat_iterator_t node{index};
+  if (!seqan::goDown(node)) {
+    return false;
+  }
+  for (unsigned i = 0; i < first_subtree; ++i) {
+    if (!seqan::goRight(node)) {
+      return false;
+    }
+  }
+
+  std::map<unsigned, pato::repeat_t> found;
+  for (unsigned i = first_subtree; i < last_subtree; ++i) {
+    find_subtree_repeats(found, node, min_repeat_length);
+    if (!seqan::goRight(node)) {
+      break;
+    }
+  }
+
+  repeats.reserve(found.size());
+  for (const auto &repeat : found) {
+    repeats.push_back(repeat.second);
+  }
+  return true;
+}
+
+void pato::mask_repeats(pato::triplex_t &sequence,
+                        const pato::repeat_vector_t &repeats) {
+  for (const auto &repeat : repeats) {
     for (unsigned i = repeat.beginPosition; i < repeat.endPosition; ++i) {
       sequence[i] = 'N';
     }
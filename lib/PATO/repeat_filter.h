@@ -30,6 +30,17 @@ namespace pato {
 void filter_repeats(repeat_vector_t &repeats, triplex_t &sequence,
                     unsigned min_repeat_length, unsigned max_repeat_period);
 
+// The repeats of a sequence can be found a range of subtrees of the root of
+// its suffix tree at a time. Every subtree finds the repeats that begin with
+// its character, exactly as filter_repeats does, so the subtrees of a long
+// sequence can be searched at once and their repeats masked afterwards.
+unsigned count_repeat_subtrees(const triplex_t &sequence,
+                               unsigned max_repeat_period);
+bool find_repeats(repeat_vector_t &repeats, const triplex_t &sequence,
+                  unsigned first_subtree, unsigned last_subtree,
+                  unsigned min_repeat_length, unsigned max_repeat_period);
+void mask_repeats(triplex_t &sequence, const repeat_vector_t &repeats);
+
 } // namespace pato
 
 #endif // PATO_LIB_REPEAT_FILTER_H
@@ -22,66 +22,291 @@
 
 #include "segment_parser.h"
 
-void pato::make_parser(pato::graph_t &parser, pato::triplex_t &valid_chars,
-                       pato::triplex_t &invalid_chars,
-                       unsigned max_interrupts) {
-  pato::vertex_descriptor_t root = seqan::addVertex(parser);
-  seqan::assignRoot(parser, root);
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <seqan/misc/bit_twiddling.h>
+
+namespace {
+
+constexpr unsigned block_size = 64;
+
+// Where a run is at the end of a block: its start, and which of the last
+// positions close a chain of j invalid characters right after a valid one
+struct parser_state_t {
+  std::size_t run_start;
+  uint64_t chains;
+};
+
+// Adds the segments of a lane as infixes of the sequence being scanned
+struct segment_adder_t {
+  pato::triplex_t &sequence;
+  pato::segment_vector_t &segments;
+
+  void operator()(std::size_t begin, std::size_t end) const {
+    segments.push_back(seqan::infix(sequence, begin, end));
+  }
+};
+
+} // namespace
+
+void pato::make_parser(pato::segment_parser_t &parser,
+                       pato::triplex_t &valid_chars,
+                       pato::triplex_t &invalid_chars) {
+  parser.classes.fill(pato::char_class_t::other);
+  parser.valid_values.clear();
+  parser.invalid_values.clear();
 
-  pato::vertex_descriptor_t valid_child = seqan::addVertex(parser);
   for (auto valid_char : valid_chars) {
-    seqan::addEdge(parser, root, valid_child, valid_char);
-    seqan::addEdge(parser, valid_child, valid_child, valid_char);
+    parser.classes[seqan::ordValue(valid_char)] = pato::char_class_t::valid;
+    parser.valid_values.push_back(seqan::ordValue(valid_char));
+  }
+  for (auto invalid_char : invalid_chars) {
+    parser.classes[seqan::ordValue(invalid_char)] = pato::char_class_t::invalid;
+    parser.invalid_values.push_back(seqan::ordValue(invalid_char));
   }
+}
 
-  pato::vertex_descriptor_t last_child = valid_child;
-  for (unsigned i = 0; i < max_interrupts; ++i) {
-    pato::vertex_descriptor_t invalid_child = seqan::addVertex(parser);
+static void classify_chars(const uint8_t *chars, unsigned count,
+                           const pato::segment_parser_t &parser,
+                           uint64_t &valid, uint64_t &invalid) {
+  valid = 0;
+  invalid = 0;
+  for (unsigned i = 0; i < count; ++i) {
+    auto char_class = parser.classes[chars[i]];
+    valid |= static_cast<uint64_t>(char_class == pato::char_class_t::valid)
+             << i;
+    invalid |= static_cast<uint64_t>(char_class == pato::char_class_t::invalid)
+               << i;
+  }
+}
 
-    for (auto invalid_char : invalid_chars) {
-      seqan::addEdge(parser, last_child, invalid_child, invalid_char);
+namespace {
+
+// A block of characters loaded once and matched against the characters of
+// every parser that scans it
+#if defined(__AVX2__)
+struct char_block_t {
+  __m256i lo;
+  __m256i hi;
+
+  explicit char_block_t(const uint8_t *chars)
+      : lo{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(chars))},
+        hi{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(chars + 32))} {
+  }
+};
+#elif defined(__SSE2__)
+struct char_block_t {
+  __m128i parts[block_size / 16];
+
+  explicit char_block_t(const uint8_t *chars) {
+    for (unsigned i = 0; i < block_size / 16; ++i) {
+      parts[i] =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(chars + 16 * i));
     }
-    for (auto valid_char : valid_chars) {
-      seqan::addEdge(parser, invalid_child, valid_child, valid_char);
+  }
+};
+#else
+struct char_block_t {
+  const uint8_t *chars;
+
+  explicit char_block_t(const uint8_t *chars_) : chars{chars_} {}
+};
+#endif
+
+} // namespace
+
+#if defined(__AVX2__)
+static uint64_t match_block(const char_block_t &block,
+                            const std::vector<uint8_t> &values) {
+  __m256i lo_matches = _mm256_setzero_si256();
+  __m256i hi_matches = _mm256_setzero_si256();
+  for (auto value : values) {
+    __m256i pattern = _mm256_set1_epi8(static_cast<char>(value));
+    lo_matches =
+        _mm256_or_si256(lo_matches, _mm256_cmpeq_epi8(block.lo, pattern));
+    hi_matches =
+        _mm256_or_si256(hi_matches, _mm256_cmpeq_epi8(block.hi, pattern));
+  }
+  return static_cast<uint32_t>(_mm256_movemask_epi8(lo_matches)) |
+         static_cast<uint64_t>(
+             static_cast<uint32_t>(_mm256_movemask_epi8(hi_matches)))
+             << 32;
+}
+#elif defined(__SSE2__)
+static uint64_t match_block(const char_block_t &block,
+                            const std::vector<uint8_t> &values) {
+  uint64_t matches = 0;
+  for (unsigned i = 0; i < block_size / 16; ++i) {
+    __m128i part_matches = _mm_setzero_si128();
+    for (auto value : values) {
+      __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+      part_matches =
+          _mm_or_si128(part_matches, _mm_cmpeq_epi8(block.parts[i], pattern));
+    }
+    matches |= static_cast<uint64_t>(_mm_movemask_epi8(part_matches))
+               << (16 * i);
+  }
+  return matches;
+}
+#endif
+
+static void classify_block(const char_block_t &block,
+                           const pato::segment_parser_t &parser,
+                           uint64_t &valid, uint64_t &invalid) {
+#if defined(__AVX2__) || defined(__SSE2__)
+  valid = match_block(block, parser.valid_values);
+  invalid = match_block(block, parser.invalid_values);
+#else
+  classify_chars(block.chars, block_size, parser, valid, invalid);
+#endif
+}
+
+// Segments the next count characters, starting at offset, given which of them
+// are valid and which are invalid. An invalid character is tolerated if it
+// closes a chain of at most max_interrupts invalid characters that follows a
+// valid one; the run ends at any other character, which is dropped together
+// with up to max_interrupts characters before it. Segments are passed to
+// add_segment as their begin and end positions.
+template <typename function_t>
+static void parse_block(parser_state_t &state, uint64_t valid, uint64_t invalid,
+                        std::size_t offset, unsigned count,
+                        unsigned max_interrupts, int min_length,
+                        function_t &&add_segment) {
+  uint64_t count_mask =
+      count < block_size ? (uint64_t{1} << count) - 1 : ~uint64_t{0};
+
+  uint64_t chain = valid;
+  uint64_t tolerated = 0;
+  uint64_t chains = 0;
+  for (unsigned j = 1; j <= max_interrupts; ++j) {
+    chains |= (chain >> (block_size - 1)) << (j - 1);
+    chain = ((chain << 1) | ((state.chains >> (j - 1)) & 1)) & invalid;
+    tolerated |= chain;
+  }
+
+  uint64_t breaks = ~(valid | tolerated) & count_mask;
+  while (breaks != 0) {
+    std::size_t pos = offset + seqan::bitScanForward(breaks);
+
+    unsigned shift = std::min(max_interrupts,
+                              static_cast<unsigned>(pos - state.run_start));
+    if (static_cast<int>(pos - shift - state.run_start) >= min_length) {
+      add_segment(state.run_start, pos - shift);
     }
+    state.run_start = pos + 1;
 
-    last_child = invalid_child;
+    breaks &= breaks - 1;
   }
+
+  state.chains = chains;
 }
 
-void pato::parse_segments(pato::graph_t &parser,
-                          pato::segment_vector_t &segments,
+void pato::parse_segments(pato::segment_lane_t *lanes, unsigned num_lanes,
                           pato::triplex_t &sequence, unsigned max_interrupts,
                           int min_length) {
-  using iterator_t = seqan::Iterator<pato::triplex_t>::Type;
+  pato::parse_segments(lanes, num_lanes, sequence, 0, seqan::length(sequence),
+                       max_interrupts, min_length);
+}
 
-  iterator_t it = seqan::begin(sequence);
-  iterator_t run_it = seqan::begin(sequence);
-  iterator_t end_it = seqan::end(sequence);
+void pato::parse_segments(pato::segment_lane_t *lanes, unsigned num_lanes,
+                          pato::triplex_t &sequence, std::size_t begin,
+                          std::size_t end, unsigned max_interrupts,
+                          int min_length) {
+  const auto *chars = reinterpret_cast<const uint8_t *>(
+      seqan::begin(sequence, seqan::Standard()));
 
-  pato::vertex_descriptor_t root = seqan::getRoot(parser);
-  seqan::parseString(parser, root, run_it, end_it);
+  std::array<parser_state_t, pato::max_segment_lanes> states;
+  states.fill(parser_state_t{begin, 0});
 
-  while (run_it != end_it) {
-    unsigned shift =
-        std::min(max_interrupts, static_cast<unsigned>(run_it - it));
-    run_it -= shift;
+  uint64_t valid;
+  uint64_t invalid;
 
-    unsigned size = std::max(run_it - run_it, run_it - it);
-    if (static_cast<int>(size) >= min_length) {
-      segments.push_back(seqan::infix(sequence, it, run_it));
+  std::size_t offset = begin;
+  for (; offset + block_size <= end; offset += block_size) {
+    char_block_t block{chars + offset};
+    for (unsigned i = 0; i < num_lanes; ++i) {
+      classify_block(block, *lanes[i].parser, valid, invalid);
+      parse_block(states[i], valid, invalid, offset, block_size,
+                  max_interrupts, min_length,
+                  segment_adder_t{sequence, *lanes[i].segments});
     }
+  }
+  if (offset < end) {
+    auto count = static_cast<unsigned>(end - offset);
+    for (unsigned i = 0; i < num_lanes; ++i) {
+      classify_chars(chars + offset, count, *lanes[i].parser, valid, invalid);
+      parse_block(states[i], valid, invalid, offset, count, max_interrupts,
+                  min_length, segment_adder_t{sequence, *lanes[i].segments});
+    }
+  }
 
-    run_it += shift + 1;
-    it = run_it;
+  for (unsigned i = 0; i < num_lanes; ++i) {
+    if (static_cast<int>(end - states[i].run_start) >= min_length) {
+      lanes[i].segments->push_back(
+          seqan::infix(sequence, states[i].run_start, end));
+    }
+  }
+}
+
+// An invalid character is tolerated if at most max_interrupts invalid
+// characters separate it from the last valid one
+std::size_t pato::find_segment_break(const pato::segment_parser_t &parser,
+                                     const pato::triplex_t &sequence,
+                                     std::size_t pos,
+                                     unsigned max_interrupts) {
+  const auto *chars = reinterpret_cast<const uint8_t *>(
+      seqan::begin(sequence, seqan::Standard()));
+  std::size_t length = seqan::length(sequence);
 
-    if (run_it != end_it) {
-      seqan::parseString(parser, root, run_it, end_it);
+  bool after_valid = false;
+  unsigned interrupts = 0;
+  for (std::size_t i = pos > max_interrupts ? pos - max_interrupts : 0;
+       i < length; ++i) {
+    auto char_class = parser.classes[chars[i]];
+    if (char_class == pato::char_class_t::valid) {
+      after_valid = true;
+      interrupts = 0;
+    } else if (char_class == pato::char_class_t::invalid && after_valid &&
+               interrupts < max_interrupts) {
+      ++interrupts;
+    } else if (i >= pos) {
+      return i;
+    } else {
+      after_valid = false;
     }
   }
+  return length;
+}
+
+void pato::parse_segments(pato::segment_parser_t &parser,
+                          pato::segment_vector_t &segments,
+                          pato::triplex_t &sequence, unsigned max_interrupts,
+                          int min_length) {
+  pato::segment_lane_t lane{&parser, &segments};
+  pato::parse_segments(&lane, 1, sequence, max_interrupts, min_length);
+}
+
+void pato::parse_segments(pato::interval_vector_t &segments,
+                          const pato::word_vector_t &valid, std::size_t length,
+                          unsigned max_interrupts, int min_length) {
+  parser_state_t state{0, 0};
+  auto add_segment = [&](std::size_t begin, std::size_t end) {
+    segments.emplace_back(begin, end);
+  };
+
+  for (std::size_t offset = 0; offset < length; offset += block_size) {
+    auto count = static_cast<unsigned>(
+        std::min<std::size_t>(length - offset, block_size));
+    uint64_t valid_block = valid[offset / block_size];
+    parse_block(state, valid_block, ~valid_block, offset, count,
+                max_interrupts, min_length, add_segment);
+  }
 
-  unsigned size = std::max(end_it - end_it, end_it - it);
-  if (static_cast<int>(size) >= min_length) {
-    segments.push_back(seqan::infix(sequence, it, end_it));
+  if (static_cast<int>(length - state.run_start) >= min_length) {
+    add_segment(state.run_start, length);
   }
 }
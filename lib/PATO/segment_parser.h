@@ -23,15 +23,57 @@
 #ifndef PATO_LIB_SEGMENT_PARSER_H
 #define PATO_LIB_SEGMENT_PARSER_H
 
+#include <array>
+
 #include "types.h"
 
 namespace pato {
 
-void make_parser(graph_t &parser, triplex_t &valid_chars,
-                 triplex_t &invalid_chars, unsigned max_interrupts);
-void parse_segments(graph_t &parser, segment_vector_t &segments,
+enum class char_class_t : uint8_t { other, valid, invalid };
+
+// Splits sequences into runs of valid characters with at most max_interrupts
+// consecutive invalid characters; any other character ends a run. The class
+// of every character value is looked up in a table, and the values themselves
+// are kept so that whole blocks of characters can be classified at once.
+struct segment_parser_t {
+  std::array<char_class_t, 256> classes;
+  std::vector<uint8_t> valid_values;
+  std::vector<uint8_t> invalid_values;
+};
+
+// Parsers that scan the same sequence together, each into its own segments
+struct segment_lane_t {
+  segment_parser_t *parser;
+  segment_vector_t *segments;
+};
+
+constexpr unsigned max_segment_lanes = 3;
+
+void make_parser(segment_parser_t &parser, triplex_t &valid_chars,
+                 triplex_t &invalid_chars);
+void parse_segments(segment_parser_t &parser, segment_vector_t &segments,
                     triplex_t &sequence, unsigned max_interrupts,
                     int min_length);
+void parse_segments(segment_lane_t *lanes, unsigned num_lanes,
+                    triplex_t &sequence, unsigned max_interrupts,
+                    int min_length);
+
+// A run always ends at a character that is not tolerated, and the next one
+// starts right after it as if the sequence began there. Cutting a sequence
+// after such characters thus splits it into windows that are segmented
+// independently into the same segments as the whole sequence.
+std::size_t find_segment_break(const segment_parser_t &parser,
+                               const triplex_t &sequence, std::size_t pos,
+                               unsigned max_interrupts);
+void parse_segments(segment_lane_t *lanes, unsigned num_lanes,
+                    triplex_t &sequence, std::size_t begin, std::size_t end,
+                    unsigned max_interrupts, int min_length);
+
+// Segments a sequence of the given length whose valid characters are the bits
+// set in valid; every other character is invalid.
+void parse_segments(interval_vector_t &segments, const word_vector_t &valid,
+                    std::size_t length, unsigned max_interrupts,
+                    int min_length);
 
 } // namespace pato
 
@@ -22,8 +22,80 @@
 
 #include "sequence_loader.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+enum class fasta_char_t : uint8_t { ignored, valid, invalid };
+
+// How seqan treats every character of a FASTA sequence read into a
+// TriplexString: whitespace is skipped and characters out of the alphabet are
+// a parse error
+struct fasta_table_t {
+  std::array<fasta_char_t, 256> classes;
+  std::array<seqan::Triplex, 256> values;
+
+  fasta_table_t() {
+    for (unsigned c = 0; c < 256; ++c) {
+      char value = static_cast<char>(c);
+      if (seqan::IsWhitespace{}(value)) {
+        classes[c] = fasta_char_t::ignored;
+      } else if (seqan::IsInAlphabet<seqan::Triplex>{}(value)) {
+        classes[c] = fasta_char_t::valid;
+      } else {
+        classes[c] = fasta_char_t::invalid;
+      }
+      values[c] = value;
+    }
+  }
+};
+
+} // namespace
+
+static const char *find_line_end(const char *begin, const char *end) {
+  return std::find_if(begin, end,
+                      [](char c) { return c == '\n' || c == '\r'; });
+}
+
+// Records start at every '>' out of a header line, as seqan::readRecord reads
+// the header up to the end of the line and the sequence up to the next '>'
+static bool index_records(std::vector<std::size_t> &record_starts,
+                          const char *data, std::size_t length) {
+  std::size_t first = 0;
+  while (first < length && seqan::IsWhitespace{}(data[first])) {
+    ++first;
+  }
+  if (first == length || data[first] != '>') {
+    return false;
+  }
+
+  const char *record = data + first;
+  const char *end = data + length;
+  while (record) {
+    record_starts.push_back(record - data);
+    const char *line_end = find_line_end(record, end);
+    record = static_cast<const char *>(
+        std::memchr(line_end, '>', end - line_end));
+  }
+  return true;
+}
+
 std::optional<pato::sequence_loader_t>
 pato::sequence_loader_t::create(const seqan::CharString &file_name) {
+  mapped_file_t *mapped_file{new mapped_file_t{}};
+  if (seqan::open(*mapped_file, seqan::toCString(file_name),
+                  seqan::OPEN_RDONLY)) {
+    std::vector<std::size_t> record_starts;
+    if (index_records(record_starts, seqan::begin(*mapped_file),
+                      seqan::length(*mapped_file))) {
+      return pato::sequence_loader_t{mapped_file, std::move(record_starts)};
+    }
+  }
+  delete mapped_file;
+
   seqan::SeqFileIn *fasta_file{new seqan::SeqFileIn{}};
   if (seqan::open(*fasta_file, seqan::toCString(file_name))) {
     return pato::sequence_loader_t{fasta_file};
@@ -38,12 +110,107 @@ static void crop_sequence_name(seqan::CharString &name) {
   name = tmp_name.substr(0, num_chars);
 }
 
+// Decodes the sequence of a record as seqan::readRecord does
+static void decode_sequence(pato::triplex_t &sequence, const char *begin,
+                            const char *end) {
+  static const fasta_table_t table;
+
+  seqan::resize(sequence, end - begin, seqan::Exact{});
+  auto *target = seqan::begin(sequence, seqan::Standard{});
+  std::size_t length = 0;
+  for (const char *source = begin; source < end; ++source) {
+    auto c = static_cast<unsigned char>(*source);
+    if (table.classes[c] == fasta_char_t::valid) {
+      target[length++] = table.values[c];
+    } else if (table.classes[c] == fasta_char_t::invalid) {
+      seqan::AssertFunctor<seqan::IsInAlphabet<seqan::Triplex>,
+                           seqan::ParseError, seqan::Fasta>{}(*source);
+    }
+  }
+  seqan::resize(sequence, length);
+}
+
+bool pato::sequence_loader_t::load_mapped_sequences(
+    pato::triplex_vector_t &sequences, pato::name_vector_t &names,
+    unsigned num_sequences, std::size_t num_bases) {
+  const char *data = seqan::begin(*mapped_file);
+  std::size_t length = seqan::length(*mapped_file);
+
+  std::size_t bases = 0;
+  for (unsigned i = 0; i < num_sequences && bases < num_bases &&
+                       next_record < record_starts.size();
+       ++i, ++next_record) {
+    const char *record = data + record_starts[next_record] + 1;
+    const char *record_end = next_record + 1 < record_starts.size()
+                                 ? data + record_starts[next_record + 1]
+                                 : data + length;
+
+    // The name is cropped at the first space of the header line
+    const char *line_end = find_line_end(record, record_end);
+    const char *name_end = std::find(record, line_end, ' ');
+    auto &name = names.emplace_back();
+    seqan::resize(name, name_end - record, seqan::Exact{});
+    std::copy(record, name_end, seqan::begin(name, seqan::Standard{}));
+
+    auto &sequence = sequences.emplace_back();
+    decode_sequence(sequence, line_end, record_end);
+    bases += seqan::length(sequence);
+  }
+  return !sequences.empty();
+}
+
 bool pato::sequence_loader_t::load_sequences(pato::triplex_vector_t &sequences,
                                              pato::name_vector_t &names,
-                                             unsigned num_sequences) {
-  seqan::readRecords(names, sequences, *fasta_file, num_sequences);
-  for (seqan::CharString &name : names) {
+                                             unsigned num_sequences,
+                                             std::size_t num_bases) {
+  if (!prefetched.valid()) {
+    return read_sequences(sequences, names, num_sequences, num_bases);
+  }
+
+  // The prefetched chunk was read into empty vectors, so it is appended to
+  // the given ones just as read_sequences would do
+  prefetched.get();
+  if (sequences.empty()) {
+    sequences.swap(prefetched_sequences);
+    names.swap(prefetched_names);
+  } else {
+    std::move(prefetched_sequences.begin(), prefetched_sequences.end(),
+              std::back_inserter(sequences));
+    std::move(prefetched_names.begin(), prefetched_names.end(),
+              std::back_inserter(names));
+  }
+  prefetched_sequences.clear();
+  prefetched_names.clear();
+  return !sequences.empty();
+}
+
+void pato::sequence_loader_t::prefetch_sequences(unsigned num_sequences,
+                                                 std::size_t num_bases) {
+  prefetched = std::async(std::launch::async, [=] {
+    return read_sequences(prefetched_sequences, prefetched_names,
+                          num_sequences, num_bases);
+  });
+}
+
+bool pato::sequence_loader_t::read_sequences(pato::triplex_vector_t &sequences,
+                                             pato::name_vector_t &names,
+                                             unsigned num_sequences,
+                                             std::size_t num_bases) {
+  if (mapped_file) {
+    return load_mapped_sequences(sequences, names, num_sequences, num_bases);
+  }
+
+  // A chunk ends once it holds the given number of sequences or bases, so the
+  // sequence that reaches the latter may exceed it
+  std::size_t bases = 0;
+  for (unsigned i = 0;
+       i < num_sequences && bases < num_bases && !seqan::atEnd(*fasta_file);
+       ++i) {
+    auto &name = names.emplace_back();
+    auto &sequence = sequences.emplace_back();
+    seqan::readRecord(name, sequence, *fasta_file);
     crop_sequence_name(name);
+    bases += seqan::length(sequence);
   }
   return !sequences.empty();
 }
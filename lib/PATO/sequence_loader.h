@@ -24,8 +24,10 @@
 #define PATO_LIB_SEQUENCE_LOADER_H
 
 #include <PATO/options.h>
+#include <seqan/file.h>
 #include <seqan/seq_io.h>
 
+#include <future>
 #include <optional>
 
 #include "types.h"
@@ -37,13 +39,42 @@ public:
   static std::optional<sequence_loader_t>
   create(const seqan::CharString &file_name);
 
+  // Reads the next chunk, which ends once it holds num_sequences sequences or
+  // at least num_bases bases
   bool load_sequences(triplex_vector_t &sequences, name_vector_t &names,
-                      unsigned num_sequences);
+                      unsigned num_sequences, std::size_t num_bases);
+  // Starts reading the next chunk on a background thread. The chunk is handed
+  // over by the following call to load_sequences.
+  void prefetch_sequences(unsigned num_sequences, std::size_t num_bases);
 
 private:
+  using mapped_file_t = seqan::String<char, seqan::MMap<>>;
+
   sequence_loader_t(seqan::SeqFileIn *fasta_file_) : fasta_file{fasta_file_} {}
+  sequence_loader_t(mapped_file_t *mapped_file_,
+                    std::vector<std::size_t> &&record_starts_)
+      : mapped_file{mapped_file_}, record_starts{std::move(record_starts_)},
+        next_record{0} {}
+
+  bool read_sequences(triplex_vector_t &sequences, name_vector_t &names,
+                      unsigned num_sequences, std::size_t num_bases);
+  bool load_mapped_sequences(triplex_vector_t &sequences, name_vector_t &names,
+                             unsigned num_sequences, std::size_t num_bases);
 
+  // Plain FASTA files are mapped into memory and their records, whose '>'
+  // positions are indexed up front, decoded straight from the mapping. Any
+  // other input, e.g. compressed or FASTQ files, is read through seqan.
   std::shared_ptr<seqan::SeqFileIn> fasta_file;
+  std::shared_ptr<mapped_file_t> mapped_file;
+  std::vector<std::size_t> record_starts;
+  std::size_t next_record;
+
+  triplex_vector_t prefetched_sequences;
+  name_vector_t prefetched_names;
+  // Declared last so that it is destroyed first: the destructor of an
+  // std::async future waits for the prefetch, which writes to the members
+  // above
+  std::future<bool> prefetched;
 };
 
 } // namespace pato
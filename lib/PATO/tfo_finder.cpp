@@ -33,9 +33,9 @@
 namespace {
 
 struct tfo_finder_args_t {
-  pato::graph_t tc_parser;
-  pato::graph_t ga_parser;
-  pato::graph_t gt_parser;
+  pato::segment_parser_t tc_parser;
+  pato::segment_parser_t ga_parser;
+  pato::segment_parser_t gt_parser;
 
   pato::repeat_vector_t repeats;
 
@@ -47,10 +47,13 @@ struct tfo_finder_args_t {
   pato::motif_potential_vector_t potentials;
 #endif
 
-  pato::char_vector_vector_t block_runs;
-  pato::char_vector_vector_t encoded_seq;
+  pato::index_vector_t block_runs;
+  pato::encoded_sequence_t encoded_seq;
+  pato::window_bounds_t window_bounds;
 
-  pato::segment_vector_t segments;
+  pato::segment_vector_t tc_segments;
+  pato::segment_vector_t ga_segments;
+  pato::segment_vector_t gt_segments;
 
   pato::guanine_filter_args_t filter_args;
 
@@ -58,28 +61,50 @@ struct tfo_finder_args_t {
   explicit tfo_finder_args_t(pato::motif_vector_t &motifs_,
                              pato::motif_potential_vector_t &potentials_)
       : motifs{motifs_}, potentials{potentials_},
-        filter_args{motifs, block_runs, encoded_seq, true, 'G', 'N'} {}
+        filter_args{motifs, block_runs, encoded_seq, window_bounds, true, 'G',
+                    'N'} {}
 #else
   tfo_finder_args_t()
-      : filter_args{motifs, block_runs, encoded_seq, true, 'G', 'N'} {}
+      : filter_args{motifs, block_runs, encoded_seq, window_bounds, true, 'G',
+                    'N'} {}
 #endif
 };
 
 } // namespace
 
-static void make_tfo_parsers(tfo_finder_args_t &args, unsigned max_interrupts) {
+static void make_tfo_parsers(tfo_finder_args_t &args) {
   pato::triplex_t valid_chars, invalid_chars;
   valid_chars = "TCY";
   invalid_chars = "GARN";
-  pato::make_parser(args.tc_parser, valid_chars, invalid_chars, max_interrupts);
+  pato::make_parser(args.tc_parser, valid_chars, invalid_chars);
 
   valid_chars = "GAR";
   invalid_chars = "TCYN";
-  pato::make_parser(args.ga_parser, valid_chars, invalid_chars, max_interrupts);
+  pato::make_parser(args.ga_parser, valid_chars, invalid_chars);
 
   valid_chars = "GTK";
   invalid_chars = "CAMN";
-  pato::make_parser(args.gt_parser, valid_chars, invalid_chars, max_interrupts);
+  pato::make_parser(args.gt_parser, valid_chars, invalid_chars);
+}
+
+// Segments the sequence for every enabled motif in a single scan
+static void parse_tfo_segments(pato::triplex_t &sequence,
+                               tfo_finder_args_t &args,
+                               const pato::options_t &opts) {
+  std::array<pato::segment_lane_t, pato::max_segment_lanes> lanes;
+  unsigned num_lanes = 0;
+  if (opts.tc_motif) {
+    lanes[num_lanes++] = {&args.tc_parser, &args.tc_segments};
+  }
+  if (opts.ga_motif) {
+    lanes[num_lanes++] = {&args.ga_parser, &args.ga_segments};
+  }
+  if (opts.gt_a_motif || opts.gt_p_motif) {
+    lanes[num_lanes++] = {&args.gt_parser, &args.gt_segments};
+  }
+
+  pato::parse_segments(lanes.data(), num_lanes, sequence,
+                       opts.max_interruptions, opts.min_length);
 }
 
 static void find_tfo_motifs(pato::triplex_t &sequence, unsigned id,
@@ -89,41 +114,34 @@ static void find_tfo_motifs(pato::triplex_t &sequence, unsigned id,
   unsigned matches_r = 0;
   unsigned matches_m = 0;
 
+  parse_tfo_segments(sequence, args, opts);
+
   // TC motif
   if (opts.tc_motif) {
-    pato::parse_segments(args.tc_parser, args.segments, sequence,
-                         opts.max_interruptions, opts.min_length);
-
     args.filter_args.ornt = pato::orientation_t::parallel;
 
-    for (auto &segment : args.segments) {
+    for (auto &segment : args.tc_segments) {
       pato::motif_t motif{segment, true, id, true, 'Y'};
       matches_y += filter_guanine_error_rate(motif, args.filter_args,
                                              pato::pyrimidine_motif_t{}, opts);
     }
-    args.segments.clear();
+    args.tc_segments.clear();
   }
 
   // GA motif
   if (opts.ga_motif) {
-    pato::parse_segments(args.ga_parser, args.segments, sequence,
-                         opts.max_interruptions, opts.min_length);
-
     args.filter_args.ornt = pato::orientation_t::antiparallel;
 
-    for (auto &segment : args.segments) {
+    for (auto &segment : args.ga_segments) {
       pato::motif_t motif{segment, false, id, true, 'R'};
       matches_r += filter_guanine_error_rate(motif, args.filter_args,
                                              pato::purine_motif_t{}, opts);
     }
-    args.segments.clear();
+    args.ga_segments.clear();
   }
 
   // GT motif
   if (opts.gt_a_motif || opts.gt_p_motif) {
-    pato::parse_segments(args.gt_parser, args.segments, sequence,
-                         opts.max_interruptions, opts.min_length);
-
     if (opts.gt_a_motif && opts.gt_p_motif &&
         opts.run_mode != pato::run_mode_t::tfo_search) {
       args.filter_args.ornt = pato::orientation_t::both;
@@ -134,23 +152,23 @@ static void find_tfo_motifs(pato::triplex_t &sequence, unsigned id,
       args.filter_args.ornt = pato::orientation_t::antiparallel;
     }
 
-    for (auto &segment : args.segments) {
-      if ((args.filter_args.ornt == pato::orientation_t::both ||
-           args.filter_args.ornt == pato::orientation_t::parallel) &&
-          opts.mixed_parallel_max_guanine >= opts.min_guanine_rate) {
+    bool parallel =
+        (args.filter_args.ornt == pato::orientation_t::both ||
+         args.filter_args.ornt == pato::orientation_t::parallel) &&
+        opts.mixed_parallel_max_guanine >= opts.min_guanine_rate;
+    bool antiparallel =
+        (args.filter_args.ornt == pato::orientation_t::both ||
+         args.filter_args.ornt == pato::orientation_t::antiparallel) &&
+        opts.mixed_antiparallel_min_guanine <= opts.max_guanine_rate;
+
+    if (parallel || antiparallel) {
+      for (auto &segment : args.gt_segments) {
         pato::motif_t motif{segment, true, id, true, 'M'};
         matches_m += filter_guanine_error_rate(motif, args.filter_args,
-                                               pato::mixed_motif_t{}, opts);
-      }
-      if ((args.filter_args.ornt == pato::orientation_t::both ||
-           args.filter_args.ornt == pato::orientation_t::antiparallel) &&
-          opts.mixed_antiparallel_min_guanine <= opts.max_guanine_rate) {
-        pato::motif_t motif{segment, false, id, true, 'M'};
-        matches_m += filter_guanine_error_rate(motif, args.filter_args,
-                                               pato::mixed_motif_t{}, opts);
+                                               parallel, antiparallel, opts);
       }
     }
-    args.segments.clear();
+    args.gt_segments.clear();
   }
 
   if (opts.run_mode == pato::run_mode_t::tfo_search) {
@@ -189,7 +207,7 @@ void pato::find_tfo_motifs(pato::motif_vector_t &motifs,
     if (opts.run_mode == run_mode_t::tfo_search) {
       args.filter_args.reduce_set = opts.merge_features;
     }
-    make_tfo_parsers(args, opts.max_interruptions);
+    make_tfo_parsers(args);
 
 #pragma omp for schedule(dynamic) nowait
     for (unsigned i = 0; i < sequences.size(); ++i) {
@@ -234,7 +252,8 @@ pato::find_tfo_motifs(const pato::options_t &opts) {
   pato::name_vector_t tfo_names;
   pato::triplex_vector_t tfo_sequences;
   sequence_loader->load_sequences(tfo_sequences, tfo_names,
-                                  std::numeric_limits<unsigned>::max());
+                                  std::numeric_limits<unsigned>::max(),
+                                  std::numeric_limits<std::size_t>::max());
   pato::motif_vector_t tfo_motifs;
   pato::motif_potential_vector_t tfo_potentials;
   pato::find_tfo_motifs(tfo_motifs, tfo_potentials, tfo_sequences, opts);
@@ -24,255 +24,963 @@
 
 #include "finders.h"
 #include "guanine_filter.h"
+#include "match_queue.h"
 #include "output_writer.h"
 #include "segment_parser.h"
 #include "sequence_loader.h"
 #include "types.h"
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
+#include <seqan/misc/bit_twiddling.h>
+
 namespace {
 
-struct tpx_finder_args_t {
-  pato::graph_t tpx_parser;
+// Matches per block handed over to the writer thread, and number of blocks
+// that may be waiting to be written
+constexpr std::size_t match_block_size = 4096;
+constexpr std::size_t match_queue_capacity = 32;
+
+// The positions of the guanines and adenines of the mask of a motif. TFO masks
+// only hold G, A and N, and TTS masks G, A and Y, so a TFO and a TTS character
+// match iff both are G or both are A.
+struct candidate_t {
+  const uint64_t *guanines;
+  const uint64_t *adenines;
+  unsigned length;
+  unsigned num_words;
+  unsigned num_guanines;
+  unsigned num_adenines;
+};
+
+// The candidates of a set of motifs, whose bits are laid out back to back in
+// buffers shared by all of them
+struct candidate_buffer_t {
+  pato::word_vector_t guanines;
+  pato::word_vector_t adenines;
+  std::vector<candidate_t> candidates;
+};
+
+// Length of the q-grams of the seed index. Characters that never match are
+// left out of the index, so q-grams are keyed on their guanines alone.
+constexpr unsigned qgram_length = 6;
+
+// Number of TTS candidates whose q-gram hits against a TFO are gathered at once
+constexpr unsigned tts_block_size = 64;
+
+// Candidate words on each side of a tile, so that the TFO and the TTS
+// candidates of a tile fit together in a typical L2 cache
+constexpr std::size_t tile_words = 4096;
+
+// Bounds on the number of tiles per thread, so that there are enough of them to
+// balance the load but not so many that scheduling them adds up
+constexpr std::size_t min_tiles_per_thread = 8;
+constexpr std::size_t max_tiles_per_thread = 4096;
+
+// Number of TFO candidates that the batched backend scores together against a
+// TTS candidate
+constexpr unsigned batch_lanes = 8;
+
+// TFO candidates of the same length that fit in a single word, one per lane.
+// Unused lanes hold no guanines nor adenines and thus never score.
+struct tfo_batch_t {
+  unsigned ids[batch_lanes];
+  uint64_t guanines[batch_lanes];
+  uint64_t adenines[batch_lanes];
+  unsigned num_lanes;
+  unsigned length;
+};
+
+// Number of (TFO sequence, TTS sequence) cells per block of potential counts
+constexpr unsigned potential_block_size = 256;
+
+struct potential_counts_t {
+  unsigned count_R;
+  unsigned count_Y;
+  unsigned count_M;
+};
+
+using potential_block_t = std::array<potential_counts_t, potential_block_size>;
+
+// The potential counts that a thread gathers for a chunk: a TFO x TTS sequence
+// matrix, row by row, that only holds the blocks of counted cells, keyed by
+// their index. The slabs of all threads are reduced block by block.
+struct potential_slab_t {
+  std::unordered_map<std::size_t, std::unique_ptr<potential_block_t>> blocks;
+  unsigned num_tts_sequences;
+};
+
+// A range of consecutive candidates and their total length
+struct candidate_range_t {
+  unsigned begin;
+  unsigned end;
+  uint64_t length;
+};
+
+// A block of the TFO x TTS pair space, along with an estimate of its cost
+struct tile_t {
+  candidate_range_t tfo_range;
+  candidate_range_t tts_range;
+  uint64_t cost;
+};
+
+struct qgram_occurrence_t {
+  unsigned id;
+  unsigned pos;
+};
+
+// Inverted index of the q-grams of the TTS candidates of a chunk. The
+// occurrences of every bucket are sorted by candidate and position.
+struct qgram_index_t {
+  pato::index_vector_t offsets;
+  std::vector<qgram_occurrence_t> occurrences;
+};
+
+struct qgram_hit_t {
+  unsigned tts_id;
+  int diag;
+};
 
+struct tpx_finder_args_t {
   pato::motif_vector_t tpx_motifs;
 
-  pato::char_vector_vector_t block_runs;
-  pato::char_vector_vector_t encoded_seq;
+  // The matching characters, the matching guanines and the mismatching
+  // characters of a diagonal, which stand for the TTS of its triplexes
+  pato::word_vector_t matched_chars;
+  pato::word_vector_t matched_guanines;
+  pato::word_vector_t mismatched_chars;
 
-  pato::segment_vector_t segments;
+  pato::index_vector_t block_runs;
+  pato::encoded_sequence_t encoded_seq;
+  pato::window_bounds_t window_bounds;
 
-  pato::match_vector_t &matches;
+  pato::interval_vector_t segments;
+  pato::interval_vector_t windows;
 
-#if !defined(_OPENMP)
-  pato::potential_map_t &potentials;
-#else
-  pato::potential_map_t potentials;
-#endif
+  std::vector<qgram_hit_t> hits;
+
+  pato::index_vector_t batch_order;
+
+  pato::match_vector_t matches;
+  pato::match_queue_t &match_queue;
+  potential_slab_t &potentials;
 
   pato::guanine_filter_args_t filter_args;
 
   int min_score;
+  int min_qgram_hits;
 
-#if !defined(_OPENMP)
-  tpx_finder_args_t(pato::match_vector_t &matches_,
-                    pato::potential_map_t &potentials_,
-                    const pato::options_t &opts)
-      : matches{matches_}, potentials{potentials_},
-        filter_args{tpx_motifs, block_runs, encoded_seq, false, 'G', 'Y'} {
+  tpx_finder_args_t(pato::match_queue_t &match_queue_,
+                    potential_slab_t &potentials_, const pato::options_t &opts)
+      : match_queue{match_queue_}, potentials{potentials_},
+        filter_args{tpx_motifs, block_runs, encoded_seq, window_bounds, false,
+                    'G', 'Y'} {
     filter_args.ornt = pato::orientation_t::both;
     min_score = opts.min_length -
                 static_cast<int>(std::ceil(opts.error_rate * opts.min_length));
   }
-#else
-  tpx_finder_args_t(pato::match_vector_t &matches_, const pato::options_t &opts)
-      : matches{matches_}, filter_args{tpx_motifs, block_runs, encoded_seq,
-                                       false,      'G',        'Y'} {
-    filter_args.ornt = pato::orientation_t::both;
-    min_score = opts.min_length -
-                static_cast<int>(std::ceil(opts.error_rate * opts.min_length));
-  }
-#endif
 };
 
 } // namespace
 
-static void make_triplex_parser(tpx_finder_args_t &args,
-                                unsigned max_interrupts) {
-  pato::triplex_t valid_chars = "GAR";
-  pato::triplex_t invalid_chars = "TCYN";
-  pato::make_parser(args.tpx_parser, valid_chars, invalid_chars,
-                    max_interrupts);
+static void pack_candidate(candidate_t &candidate, uint64_t *guanines,
+                           uint64_t *adenines, pato::motif_t &motif) {
+  candidate.num_guanines = 0;
+  candidate.num_adenines = 0;
+  seqan::visitMask(motif, [&](auto &mask) {
+    unsigned i = 0;
+    for (auto c : mask) {
+      uint64_t bit = uint64_t{1} << (i & 63);
+      if (c == 'G') {
+        guanines[i >> 6] |= bit;
+        ++candidate.num_guanines;
+      } else if (c == 'A') {
+        adenines[i >> 6] |= bit;
+        ++candidate.num_adenines;
+      }
+      ++i;
+    }
+  });
+  candidate.guanines = guanines;
+  candidate.adenines = adenines;
 }
 
-static unsigned find_tpx_motifs(pato::triplex_t &sequence, unsigned id,
-                                tpx_finder_args_t &tpx_args,
-                                const pato::options_t &opts) {
-  pato::parse_segments(tpx_args.tpx_parser, tpx_args.segments, sequence,
-                       opts.max_interruptions, opts.min_length);
+// Packs the masks of the motifs straight from their hosts, without
+// materializing them
+static void make_candidates(candidate_buffer_t &buffer,
+                            pato::motif_vector_t &motifs) {
+  buffer.candidates.resize(motifs.size());
+
+  std::vector<std::size_t> offsets(motifs.size());
+  std::size_t num_words = 0;
+  for (std::size_t i = 0; i < motifs.size(); ++i) {
+    auto &candidate = buffer.candidates[i];
+    candidate.length = seqan::length(motifs[i]);
+    candidate.num_words = candidate.length / 64 + 1;
+    offsets[i] = num_words;
+    num_words += candidate.num_words;
+  }
+  buffer.guanines.assign(num_words, 0);
+  buffer.adenines.assign(num_words, 0);
+
+#pragma omp parallel for schedule(static)
+  for (std::size_t i = 0; i < motifs.size(); ++i) {
+    pack_candidate(buffer.candidates[i], buffer.guanines.data() + offsets[i],
+                   buffer.adenines.data() + offsets[i], motifs[i]);
+  }
+}
+
+// No diagonal can match more guanines or adenines than either candidate holds
+static int max_matches(const candidate_t &tfo_candidate,
+                       const candidate_t &tts_candidate) {
+  return std::min(tfo_candidate.num_guanines, tts_candidate.num_guanines) +
+         std::min(tfo_candidate.num_adenines, tts_candidate.num_adenines);
+}
+
+// The 64 bits starting at pos, with those past the end of bits set to zero
+static uint64_t extract_word(const uint64_t *bits, unsigned num_words,
+                             unsigned pos) {
+  unsigned word = pos >> 6;
+  unsigned shift = pos & 63;
+  uint64_t bits_word = bits[word] >> shift;
+  if (shift != 0 && word + 1 < num_words) {
+    bits_word |= bits[word + 1] << (64 - shift);
+  }
+  return bits_word;
+}
 
-  unsigned matches = 0;
+static uint64_t extract_guanines(const candidate_t &candidate, unsigned pos) {
+  return extract_word(candidate.guanines, candidate.num_words, pos);
+}
+
+static uint64_t extract_adenines(const candidate_t &candidate, unsigned pos) {
+  return extract_word(candidate.adenines, candidate.num_words, pos);
+}
+
+// Number of matching characters between the TFO and the TTS on a diagonal,
+// 64 positions per step
+static int count_matches(const candidate_t &tfo_candidate, unsigned tfo_offset,
+                         const candidate_t &tts_candidate, unsigned tts_offset,
+                         unsigned match_length) {
+  int match_score = 0;
+  for (unsigned i = 0; i < match_length; i += 64) {
+    uint64_t mask = match_length - i < 64
+                        ? (uint64_t{1} << (match_length - i)) - 1
+                        : ~uint64_t{0};
+    uint64_t guanines = extract_guanines(tfo_candidate, tfo_offset + i) &
+                        extract_guanines(tts_candidate, tts_offset + i);
+    uint64_t adenines = extract_adenines(tfo_candidate, tfo_offset + i) &
+                        extract_adenines(tts_candidate, tts_offset + i);
+    match_score += seqan::popCount((guanines | adenines) & mask);
+  }
+  return match_score;
+}
+
+static void add_potential(potential_slab_t &slab, unsigned tfo_sequence,
+                          unsigned tts_sequence, unsigned count, char motif) {
+  std::size_t cell =
+      static_cast<std::size_t>(tfo_sequence) * slab.num_tts_sequences +
+      tts_sequence;
+  auto &block = slab.blocks[cell / potential_block_size];
+  if (!block) {
+    block = std::make_unique<potential_block_t>();
+  }
+
+  auto &counts = (*block)[cell % potential_block_size];
+  if (motif == 'R' || motif == '+') {
+    counts.count_R += count;
+  } else if (motif == 'Y' || motif == '-') {
+    counts.count_Y += count;
+  } else if (motif == 'M') {
+    counts.count_M += count;
+  }
+}
+
+// Lists the indices of the blocks held by any slab, in order, and makes room
+// for each of them in the first slab
+static void list_potential_blocks(std::vector<std::size_t> &indices,
+                                  std::vector<potential_slab_t> &slabs) {
+  indices.clear();
+  for (const auto &slab : slabs) {
+    for (const auto &entry : slab.blocks) {
+      indices.push_back(entry.first);
+    }
+  }
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+  for (auto index : indices) {
+    slabs[0].blocks[index];
+  }
+}
+
+// Adds up the blocks of every slab at the given index into the first slab. The
+// slabs are only looked up, so several indices can be reduced at once.
+static void reduce_potentials(std::vector<potential_slab_t> &slabs,
+                              std::size_t index) {
+  auto &block = slabs[0].blocks.find(index)->second;
+  for (std::size_t i = 1; i < slabs.size(); ++i) {
+    auto entry = slabs[i].blocks.find(index);
+    if (entry == slabs[i].blocks.end()) {
+      continue;
+    }
+
+    auto &other_block = entry->second;
+    if (!block) {
+      block = std::move(other_block);
+      continue;
+    }
+
+    for (unsigned j = 0; j < potential_block_size; ++j) {
+      (*block)[j].count_R += (*other_block)[j].count_R;
+      (*block)[j].count_Y += (*other_block)[j].count_Y;
+      (*block)[j].count_M += (*other_block)[j].count_M;
+    }
+    other_block.reset();
+  }
+}
+
+// Number of sequences of the motifs and the length of each of them
+static void get_sequence_lengths(pato::index_vector_t &lengths,
+                                 pato::motif_vector_t &motifs) {
+  lengths.clear();
+  for (auto &motif : motifs) {
+    auto sequence = seqan::getSequenceNo(motif);
+    if (sequence >= lengths.size()) {
+      lengths.resize(sequence + 1, 0);
+    }
+    lengths[sequence] = seqan::length(seqan::host(motif));
+  }
+}
+
+// Flags the matching characters, the matching guanines and the mismatching
+// characters of the diagonal
+static void encode_diagonal(const candidate_t &tfo_candidate,
+                            unsigned tfo_offset,
+                            const candidate_t &tts_candidate,
+                            unsigned tts_offset, unsigned match_length,
+                            tpx_finder_args_t &tpx_args) {
+  unsigned num_words = match_length / 64 + 1;
+  tpx_args.matched_chars.resize(num_words);
+  tpx_args.matched_guanines.resize(num_words);
+  tpx_args.mismatched_chars.resize(num_words);
+
+  for (unsigned i = 0; i < num_words; ++i) {
+    unsigned pos = 64 * i;
+    uint64_t mask = match_length - pos < 64
+                        ? (uint64_t{1} << (match_length - pos)) - 1
+                        : ~uint64_t{0};
+    uint64_t guanines = extract_guanines(tfo_candidate, tfo_offset + pos) &
+                        extract_guanines(tts_candidate, tts_offset + pos);
+    uint64_t adenines = extract_adenines(tfo_candidate, tfo_offset + pos) &
+                        extract_adenines(tts_candidate, tts_offset + pos);
+    tpx_args.matched_chars[i] = (guanines | adenines) & mask;
+    tpx_args.matched_guanines[i] = guanines & mask;
+    tpx_args.mismatched_chars[i] = ~(guanines | adenines) & mask;
+  }
+}
+
+// Number of bits set in [begin, end)
+static unsigned count_bits(const pato::word_vector_t &bits, unsigned begin,
+                           unsigned end) {
+  unsigned count = 0;
+  for (unsigned pos = begin; pos < end; pos += 64) {
+    uint64_t word = extract_word(bits.data(), bits.size(), pos);
+    if (end - pos < 64) {
+      word &= (uint64_t{1} << (end - pos)) - 1;
+    }
+    count += seqan::popCount(word);
+  }
+  return count;
+}
+
+static void search_diagonal(pato::motif_t &tfo_motif,
+                            const candidate_t &tfo_bits, unsigned tfo_id,
+                            pato::motif_t &tts_motif,
+                            const candidate_t &tts_bits, unsigned tts_id,
+                            int diag, tpx_finder_args_t &tpx_args,
+                            const pato::options_t &opts) {
+  int tfo_length = tfo_bits.length;
+  int tts_length = tts_bits.length;
+
+  int tfo_offset = 0;
+  int tts_offset = 0;
+  if (diag < 0) {
+    tts_offset = -diag;
+  } else {
+    tfo_offset = diag;
+  }
+  int match_length = std::min(tts_length - tts_offset, tfo_length - tfo_offset);
+
+  int match_score = count_matches(tfo_bits, tfo_offset, tts_bits, tts_offset,
+                                  match_length);
+  if (match_score < tpx_args.min_score) {
+    return;
+  }
+
+  encode_diagonal(tfo_bits, tfo_offset, tts_bits, tts_offset, match_length,
+                  tpx_args);
+
+  pato::parse_segments(tpx_args.segments, tpx_args.matched_chars,
+                       match_length, opts.max_interruptions, opts.min_length);
+
+  // Purines rather than guanines are counted when there is no minimum guanine
+  // rate, as the RY filter of the motifs does
+  const auto &filter_chars = opts.min_guanine_rate <= 0.0
+                                 ? tpx_args.matched_chars
+                                 : tpx_args.matched_guanines;
+  unsigned total = 0;
   for (auto &segment : tpx_args.segments) {
-    pato::motif_t motif{segment, true, id, false, '+'};
-    matches += filter_guanine_error_rate(motif, tpx_args.filter_args,
-                                         pato::tts_t{}, opts);
+    total += pato::filter_guanine_error_rate(
+        filter_chars, tpx_args.mismatched_chars, segment, tpx_args.filter_args,
+        tpx_args.windows, opts);
   }
   tpx_args.segments.clear();
 
-  return matches;
+  if (total == 0) {
+    tpx_args.windows.clear();
+    return;
+  }
+
+  add_potential(tpx_args.potentials, seqan::getSequenceNo(tfo_motif),
+                seqan::getSequenceNo(tts_motif), total,
+                seqan::getMotif(tfo_motif));
+
+  // The summary is built from the potentials alone, so there is no need to
+  // locate and record the triplexes
+  if (opts.output_format == pato::output_format_t::summary) {
+    tpx_args.windows.clear();
+    return;
+  }
+
+  char strand;
+  std::size_t tfo_start, tfo_end;
+  std::size_t tts_start, tts_end;
+  for (auto &window : tpx_args.windows) {
+    unsigned score =
+        count_bits(tpx_args.matched_chars, window.first, window.second);
+    unsigned guanines =
+        count_bits(tpx_args.matched_guanines, window.first, window.second);
+    unsigned window_length = window.second - window.first;
+
+    if (seqan::isParallel(tfo_motif)) {
+      tfo_start = tfo_offset + seqan::beginPosition(tfo_motif) + window.first;
+      tfo_end = tfo_start + window_length;
+    } else {
+      tfo_end = seqan::endPosition(tfo_motif) - (tfo_offset + window.first);
+      tfo_start = tfo_end - window_length;
+    }
+
+    if (seqan::getMotif(tts_motif) == '+') {
+      tts_start = tts_offset + seqan::beginPosition(tts_motif) + window.first;
+      tts_end = tts_start + window_length;
+      strand = '+';
+    } else {
+      tts_end = seqan::endPosition(tts_motif) - (tts_offset + window.first);
+      tts_start = tts_end - window_length;
+      strand = '-';
+    }
+
+    pato::match_t match{tfo_id,
+                        static_cast<long>(tfo_start),
+                        static_cast<long>(tfo_end),
+                        seqan::getSequenceNo(tts_motif),
+                        tts_id,
+                        static_cast<long>(tts_start),
+                        static_cast<long>(tts_end),
+                        score,
+                        seqan::isParallel(tfo_motif),
+                        seqan::getMotif(tfo_motif),
+                        strand,
+                        guanines};
+    tpx_args.matches.push_back(match);
+    if (tpx_args.matches.size() >= match_block_size) {
+      tpx_args.match_queue.push(tpx_args.matches);
+    }
+  }
+  tpx_args.windows.clear();
 }
 
-static void search_triplex(pato::motif_t &tfo_motif, unsigned tfo_id,
-                           pato::motif_t &tts_motif, unsigned tts_id,
+static void search_triplex(pato::motif_t &tfo_motif,
+                           const candidate_t &tfo_bits, unsigned tfo_id,
+                           pato::motif_t &tts_motif,
+                           const candidate_t &tts_bits, unsigned tts_id,
                            tpx_finder_args_t &tpx_args,
                            const pato::options_t &opts) {
-  auto tfo_candidate = seqan::ttsString(tfo_motif);
-  auto tts_candidate = seqan::ttsString(tts_motif);
-
-  int tfo_length = seqan::length(tfo_candidate);
-  int tts_length = seqan::length(tts_candidate);
+  int tfo_length = tfo_bits.length;
+  int tts_length = tts_bits.length;
 
   for (int diag = -(tts_length - opts.min_length);
        diag <= tfo_length - opts.min_length; ++diag) {
-    int tfo_offset = 0;
-    int tts_offset = 0;
-    if (diag < 0) {
-      tts_offset = -diag;
-    } else {
-      tfo_offset = diag;
+    search_diagonal(tfo_motif, tfo_bits, tfo_id, tts_motif, tts_bits, tts_id,
+                    diag, tpx_args, opts);
+  }
+}
+
+// Calls f with the key and the position of every q-gram of the candidate that
+// only holds guanines and adenines: no other character of a TFO or a TTS ever
+// matches, so the remaining q-grams can never be shared.
+template <typename function_t>
+static void for_each_qgram(const candidate_t &candidate, function_t &&f) {
+  unsigned key = 0;
+  unsigned run_length = 0;
+  for (unsigned i = 0; i < candidate.length; ++i) {
+    uint64_t bit = uint64_t{1} << (i & 63);
+    bool guanine = candidate.guanines[i >> 6] & bit;
+    if (!guanine && !(candidate.adenines[i >> 6] & bit)) {
+      run_length = 0;
+      continue;
     }
-    int match_length =
-        std::min(tts_length - tts_offset, tfo_length - tfo_offset);
+    key = ((key << 1) | guanine) & ((1u << qgram_length) - 1);
+    if (++run_length >= qgram_length) {
+      f(key, i + 1 - qgram_length);
+    }
+  }
+}
+
+static void make_qgram_index(qgram_index_t &index,
+                             const std::vector<candidate_t> &candidates) {
+  index.offsets.assign((1u << qgram_length) + 1, 0);
+  for (const auto &candidate : candidates) {
+    for_each_qgram(candidate,
+                   [&](unsigned key, unsigned) { ++index.offsets[key + 1]; });
+  }
+  std::partial_sum(index.offsets.begin(), index.offsets.end(),
+                   index.offsets.begin());
+
+  index.occurrences.resize(index.offsets.back());
+  pato::index_vector_t cursors(index.offsets.begin(), index.offsets.end() - 1);
+  for (unsigned id = 0; id < candidates.size(); ++id) {
+    for_each_qgram(candidates[id], [&](unsigned key, unsigned pos) {
+      index.occurrences[cursors[key]++] = {id, pos};
+    });
+  }
+}
+
+// By the q-gram lemma, a triplex of length l with m mismatches shares at least
+// l - q + 1 - m * q q-grams with its TTS, as each mismatch breaks at most q of
+// them. This is the fewest that a triplex of any length shares, given the
+// mismatches that the guanine filter lets through, so a diagonal with fewer
+// hits holds no triplex. It is zero if some triplex may share none.
+static int qgram_threshold(const pato::options_t &opts) {
+  int q = static_cast<int>(qgram_length);
+  double loss = opts.error_rate * q;
+  bool bounded = opts.max_length >= opts.min_length;
+  if (!bounded && opts.maximal_error < 0 && loss >= 1.0) {
+    return 0;
+  }
+
+  int threshold = std::numeric_limits<int>::max();
+  int max_mismatches = 0;
+  for (int length = opts.min_length; !bounded || length <= opts.max_length;
+       ++length) {
+    while (max_mismatches < length &&
+           static_cast<double>(max_mismatches + 1) / length <=
+               opts.error_rate) {
+      ++max_mismatches;
+    }
+    int mismatches = opts.maximal_error < 0
+                         ? max_mismatches
+                         : std::min(max_mismatches, opts.maximal_error);
+    threshold = std::min(threshold, length - q + 1 - mismatches * q);
+    if (threshold <= 0) {
+      return 0;
+    }
+
+    // The q-grams that longer triplexes share only grow from here on
+    int next = length + 1;
+    if ((loss < 1.0 && next * (1.0 - loss) - q + 1 >= threshold) ||
+        (opts.maximal_error >= 0 &&
+         next - q + 1 - opts.maximal_error * q >= threshold)) {
+      break;
+    }
+  }
+  return threshold;
+}
+
+// Searches a TFO against a block of TTS candidates. With an index, only the
+// diagonals with enough hits to hold a triplex are verified.
+static void search_triplex_block(pato::motif_vector_t &tfo_motifs,
+                                const std::vector<candidate_t> &tfo_candidates,
+                                unsigned tfo_id,
+                                pato::motif_vector_t &tts_motifs,
+                                const std::vector<candidate_t> &tts_candidates,
+                                unsigned tts_begin, unsigned tts_end,
+                                const qgram_index_t *index,
+                                tpx_finder_args_t &tpx_args,
+                                const pato::options_t &opts) {
+  const auto &tfo_bits = tfo_candidates[tfo_id];
+  int tfo_length = tfo_bits.length;
 
-    int match_score = 0;
-    for (int i = 0; i < match_length; ++i) {
-      if (tfo_candidate[tfo_offset + i] == tts_candidate[tts_offset + i]) {
-        ++match_score;
+  auto &hits = tpx_args.hits;
+  hits.clear();
+  if (index != nullptr) {
+    for_each_qgram(tfo_bits, [&](unsigned key, unsigned pos) {
+      auto first = index->occurrences.begin() + index->offsets[key];
+      auto last = index->occurrences.begin() + index->offsets[key + 1];
+      first = std::lower_bound(
+          first, last, tts_begin,
+          [](const qgram_occurrence_t &occurrence, unsigned id) {
+            return occurrence.id < id;
+          });
+      for (; first != last && first->id < tts_end; ++first) {
+        hits.push_back({first->id, static_cast<int>(pos) -
+                                       static_cast<int>(first->pos)});
       }
+    });
+    std::sort(hits.begin(), hits.end(),
+              [](const qgram_hit_t &a, const qgram_hit_t &b) {
+                return a.tts_id < b.tts_id ||
+                       (a.tts_id == b.tts_id && a.diag < b.diag);
+              });
+  }
+
+  auto hit = hits.begin();
+  for (unsigned tts_id = tts_begin; tts_id < tts_end; ++tts_id) {
+    const auto &tts_bits = tts_candidates[tts_id];
+    int tts_length = tts_bits.length;
+
+    if (max_matches(tfo_bits, tts_bits) < tpx_args.min_score) {
+      continue;
     }
-    if (match_score < tpx_args.min_score) {
+
+    if (index == nullptr) {
+      search_triplex(tfo_motifs[tfo_id], tfo_bits, tfo_id, tts_motifs[tts_id],
+                     tts_bits, tts_id, tpx_args, opts);
       continue;
     }
 
-    pato::triplex_t tmp_tts{
-        seqan::infix(tts_candidate, tts_offset, tts_offset + match_length)};
+    while (hit != hits.end() && hit->tts_id < tts_id) {
+      ++hit;
+    }
+    while (hit != hits.end() && hit->tts_id == tts_id) {
+      auto last = hit;
+      while (last != hits.end() && last->tts_id == tts_id &&
+             last->diag == hit->diag) {
+        ++last;
+      }
 
-    for (int i = 0; i < match_length; ++i) {
-      if (tmp_tts[i] != tfo_candidate[tfo_offset + i]) {
-        tmp_tts[i] = 'N';
+      int diag = hit->diag;
+      int match_length = diag < 0 ? std::min(tts_length + diag, tfo_length)
+                                  : std::min(tts_length, tfo_length - diag);
+      if (match_length >= opts.min_length &&
+          last - hit >= tpx_args.min_qgram_hits) {
+        search_diagonal(tfo_motifs[tfo_id], tfo_bits, tfo_id,
+                        tts_motifs[tts_id], tts_bits, tts_id, diag, tpx_args,
+                        opts);
       }
+      hit = last;
     }
+  }
+}
 
-    unsigned total = find_tpx_motifs(tmp_tts, seqan::getSequenceNo(tts_motif),
-                                     tpx_args, opts);
-    if (total == 0) {
-      tpx_args.tpx_motifs.clear();
+// Scores every lane of the batch against a TTS candidate that fits in a word,
+// one diagonal at a time, and searches the diagonals whose score reaches
+// min_score. The lanes are laid out so that the compiler can score them with
+// vector and population count instructions, which a portable build does not
+// use unless PATO_ENABLE_NATIVE is set.
+static void search_triplex_batch(pato::motif_vector_t &tfo_motifs,
+                                 const std::vector<candidate_t> &tfo_candidates,
+                                 const tfo_batch_t &batch,
+                                 pato::motif_t &tts_motif,
+                                 const candidate_t &tts_candidate,
+                                 unsigned tts_id, tpx_finder_args_t &tpx_args,
+                                 const pato::options_t &opts) {
+  bool active[batch_lanes] = {};
+  bool any_active = false;
+  for (unsigned k = 0; k < batch.num_lanes; ++k) {
+    active[k] = max_matches(tfo_candidates[batch.ids[k]], tts_candidate) >=
+                tpx_args.min_score;
+    any_active |= active[k];
+  }
+  if (!any_active) {
+    return;
+  }
+
+  int tfo_length = batch.length;
+  int tts_length = tts_candidate.length;
+  for (int diag = -(tts_length - opts.min_length);
+       diag <= tfo_length - opts.min_length; ++diag) {
+    unsigned tfo_shift = diag > 0 ? diag : 0;
+    unsigned tts_shift = diag < 0 ? -diag : 0;
+    unsigned match_length =
+        std::min(tfo_length - tfo_shift, tts_length - tts_shift);
+    uint64_t mask = match_length < 64 ? (uint64_t{1} << match_length) - 1
+                                      : ~uint64_t{0};
+    uint64_t tts_guanines = tts_candidate.guanines[0] >> tts_shift;
+    uint64_t tts_adenines = tts_candidate.adenines[0] >> tts_shift;
+
+    int scores[batch_lanes];
+    for (unsigned k = 0; k < batch_lanes; ++k) {
+      uint64_t matches = ((batch.guanines[k] >> tfo_shift) & tts_guanines) |
+                         ((batch.adenines[k] >> tfo_shift) & tts_adenines);
+      scores[k] = seqan::popCount(matches & mask);
+    }
+
+    for (unsigned k = 0; k < batch.num_lanes; ++k) {
+      if (active[k] && scores[k] >= tpx_args.min_score) {
+        unsigned tfo_id = batch.ids[k];
+        search_diagonal(tfo_motifs[tfo_id], tfo_candidates[tfo_id], tfo_id,
+                        tts_motif, tts_candidate, tts_id, diag, tpx_args,
+                        opts);
+      }
+    }
+  }
+}
+
+// Searches a tile with the batched backend: the TFO candidates that fit in a
+// word are grouped by length into batches, which are scored together against
+// every TTS candidate that also fits in a word. Any other pair is searched one
+// at a time.
+static void search_triplex_batches(
+    pato::motif_vector_t &tfo_motifs,
+    const std::vector<candidate_t> &tfo_candidates,
+    const candidate_range_t &tfo_range, pato::motif_vector_t &tts_motifs,
+    const std::vector<candidate_t> &tts_candidates,
+    const candidate_range_t &tts_range, const qgram_index_t *index,
+    tpx_finder_args_t &tpx_args, const pato::options_t &opts) {
+  auto &batch_order = tpx_args.batch_order;
+  batch_order.clear();
+  for (unsigned i = tfo_range.begin; i < tfo_range.end; ++i) {
+    if (tfo_candidates[i].length < 64) {
+      batch_order.push_back(i);
       continue;
     }
+    for (unsigned tts_begin = tts_range.begin; tts_begin < tts_range.end;
+         tts_begin += tts_block_size) {
+      unsigned tts_end = std::min(tts_begin + tts_block_size, tts_range.end);
+      search_triplex_block(tfo_motifs, tfo_candidates, i, tts_motifs,
+                           tts_candidates, tts_begin, tts_end, index, tpx_args,
+                           opts);
+    }
+  }
+  std::sort(batch_order.begin(), batch_order.end(),
+            [&](unsigned i, unsigned j) {
+              return tfo_candidates[i].length < tfo_candidates[j].length ||
+                     (tfo_candidates[i].length == tfo_candidates[j].length &&
+                      i < j);
+            });
 
-    char strand;
-    std::size_t tfo_start, tfo_end;
-    std::size_t tts_start, tts_end;
-    for (auto &triplex : tpx_args.tpx_motifs) {
-      unsigned score = 0;
-      unsigned guanines = 0;
+  auto first = batch_order.begin();
+  while (first != batch_order.end()) {
+    tfo_batch_t batch{};
+    batch.length = tfo_candidates[*first].length;
+    for (; first != batch_order.end() && batch.num_lanes < batch_lanes &&
+           tfo_candidates[*first].length == batch.length;
+         ++first) {
+      const auto &tfo_candidate = tfo_candidates[*first];
+      batch.ids[batch.num_lanes] = *first;
+      batch.guanines[batch.num_lanes] = tfo_candidate.guanines[0];
+      batch.adenines[batch.num_lanes] = tfo_candidate.adenines[0];
+      ++batch.num_lanes;
+    }
 
-      for (unsigned i = seqan::beginPosition(triplex);
-           i < seqan::endPosition(triplex); ++i) {
-        if (tmp_tts[i] != 'N') {
-          ++score;
-        }
-        if (tmp_tts[i] == 'G') {
-          ++guanines;
+    for (unsigned j = tts_range.begin; j < tts_range.end; ++j) {
+      const auto &tts_candidate = tts_candidates[j];
+      if (tts_candidate.length < 64) {
+        search_triplex_batch(tfo_motifs, tfo_candidates, batch, tts_motifs[j],
+                             tts_candidate, j, tpx_args, opts);
+        continue;
+      }
+      for (unsigned k = 0; k < batch.num_lanes; ++k) {
+        unsigned i = batch.ids[k];
+        if (max_matches(tfo_candidates[i], tts_candidate) >=
+            tpx_args.min_score) {
+          search_triplex(tfo_motifs[i], tfo_candidates[i], i, tts_motifs[j],
+                         tts_candidate, j, tpx_args, opts);
         }
       }
+    }
+  }
+}
 
-      if (seqan::isParallel(tfo_motif)) {
-        tfo_start = tfo_offset + seqan::beginPosition(tfo_motif) +
-                    seqan::beginPosition(triplex);
-        tfo_end = tfo_start + seqan::length(triplex);
-      } else {
-        tfo_end = seqan::endPosition(tfo_motif) -
-                  (tfo_offset + seqan::beginPosition(triplex));
-        tfo_start = tfo_end - seqan::length(triplex);
-      }
+// Splits the candidates into ranges of consecutive candidates that hold at
+// most max_words words, unless a single candidate holds more
+static void split_candidates(std::vector<candidate_range_t> &ranges,
+                             const std::vector<candidate_t> &candidates,
+                             std::size_t max_words) {
+  ranges.clear();
 
-      if (seqan::getMotif(tts_motif) == '+') {
-        tts_start = tts_offset + seqan::beginPosition(tts_motif) +
-                    seqan::beginPosition(triplex);
-        tts_end = tts_start + seqan::length(triplex);
-        strand = '+';
-      } else {
-        tts_end = seqan::endPosition(tts_motif) -
-                  (tts_offset + seqan::beginPosition(triplex));
-        tts_start = tts_end - seqan::length(triplex);
-        strand = '-';
-      }
+  candidate_range_t range{0, 0, 0};
+  std::size_t num_words = 0;
+  for (unsigned i = 0; i < candidates.size(); ++i) {
+    if (range.end > range.begin &&
+        num_words + candidates[i].num_words > max_words) {
+      ranges.push_back(range);
+      range = candidate_range_t{i, i, 0};
+      num_words = 0;
+    }
+    ++range.end;
+    range.length += candidates[i].length;
+    num_words += candidates[i].num_words;
+  }
+  if (range.end > range.begin) {
+    ranges.push_back(range);
+  }
+}
 
-      pato::match_t match{tfo_id,
-                          static_cast<long>(tfo_start),
-                          static_cast<long>(tfo_end),
-                          seqan::getSequenceNo(tts_motif),
-                          tts_id,
-                          static_cast<long>(tts_start),
-                          static_cast<long>(tts_end),
-                          score,
-                          seqan::isParallel(tfo_motif),
-                          seqan::getMotif(tfo_motif),
-                          strand,
-                          guanines};
-      tpx_args.matches.push_back(match);
-    }
-    tpx_args.tpx_motifs.clear();
-
-    auto key = std::make_pair(seqan::getSequenceNo(tfo_motif),
-                              seqan::getSequenceNo(tts_motif));
-    auto result_ptr = tpx_args.potentials.find(key);
-    if (result_ptr != tpx_args.potentials.end()) {
-      seqan::addCount(result_ptr->second, total, seqan::getMotif(tfo_motif));
-    } else {
-      pato::potential_t potential(key);
-      seqan::addCount(potential, total, seqan::getMotif(tfo_motif));
-      seqan::setNorm(potential, seqan::length(seqan::host(tfo_motif)),
-                     seqan::length(seqan::host(tts_motif)), opts.max_length,
-                     opts.min_length);
-      tpx_args.potentials.insert(
-          std::make_pair(std::move(key), std::move(potential)));
+// Splits the pair space into tiles whose candidates fit in cache, shrinking or
+// growing them while there are too few or too many tiles for the threads. The
+// tiles are sorted by decreasing cost, the product of the lengths of their
+// candidates, so that the most expensive ones are started first and the cheap
+// ones fill in the gaps at the end.
+static void make_tiles(std::vector<tile_t> &tiles,
+                       const std::vector<candidate_t> &tfo_candidates,
+                       const std::vector<candidate_t> &tts_candidates) {
+  tiles.clear();
+  if (tfo_candidates.empty() || tts_candidates.empty()) {
+    return;
+  }
+
+#if defined(_OPENMP)
+  std::size_t num_threads = omp_get_max_threads();
+#else
+  std::size_t num_threads = 1;
+#endif
+  std::size_t min_tiles = min_tiles_per_thread * num_threads;
+  std::size_t max_tiles = max_tiles_per_thread * num_threads;
+
+  std::vector<candidate_range_t> tfo_ranges;
+  std::vector<candidate_range_t> tts_ranges;
+  std::size_t max_words = tile_words;
+  split_candidates(tfo_ranges, tfo_candidates, max_words);
+  split_candidates(tts_ranges, tts_candidates, max_words);
+  while (tfo_ranges.size() * tts_ranges.size() > max_tiles) {
+    max_words *= 2;
+    split_candidates(tfo_ranges, tfo_candidates, max_words);
+    split_candidates(tts_ranges, tts_candidates, max_words);
+  }
+  while (tfo_ranges.size() * tts_ranges.size() < min_tiles &&
+         (tfo_ranges.size() < tfo_candidates.size() ||
+          tts_ranges.size() < tts_candidates.size())) {
+    max_words /= 2;
+    split_candidates(tfo_ranges, tfo_candidates, max_words);
+    split_candidates(tts_ranges, tts_candidates, max_words);
+  }
+
+  for (const auto &tfo_range : tfo_ranges) {
+    for (const auto &tts_range : tts_ranges) {
+      tiles.push_back({tfo_range, tts_range,
+                       tfo_range.length * tts_range.length});
     }
   }
+  std::stable_sort(tiles.begin(), tiles.end(),
+                   [](const tile_t &a, const tile_t &b) {
+                     return a.cost > b.cost;
+                   });
 }
 
-static void match_tfo_tts_motifs(
+static void match_tfo_tts_motifs(pato::match_queue_t &match_queue,
+                                 pato::potential_vector_t &potentials,
+                                 pato::motif_vector_t &tfo_motifs,
+                                 pato::motif_vector_t &tts_motifs,
+                                 const candidate_buffer_t &tfo_buffer,
+                                 candidate_buffer_t &tts_buffer,
+                                 const pato::options_t &opts) {
+  // The TFO candidates are packed once for all chunks, whereas the TTS
+  // candidates reuse the buffer of the previous chunk
+  make_candidates(tts_buffer, tts_motifs);
+  const auto &tfo_candidates = tfo_buffer.candidates;
+  const auto &tts_candidates = tts_buffer.candidates;
+  qgram_index_t qgram_index;
+
+  std::vector<tile_t> tiles;
+  make_tiles(tiles, tfo_candidates, tts_candidates);
+
+  pato::index_vector_t tfo_lengths;
+  pato::index_vector_t tts_lengths;
+  get_sequence_lengths(tfo_lengths, tfo_motifs);
+  get_sequence_lengths(tts_lengths, tts_motifs);
+
 #if !defined(_OPENMP)
-    pato::match_vector_t &matches, pato::potential_map_t &potentials,
-    pato::motif_vector_t &tfo_motifs, pato::motif_vector_t &tts_motifs,
-    const pato::options_t &opts
+  std::vector<potential_slab_t> slabs(1);
 #else
-    pato::match_vector_vector_t &matches, pato::potential_map_t &potentials,
-    pato::motif_vector_t &tfo_motifs, pato::motif_vector_t &tts_motifs,
-    const pato::options_t &opts
-#endif
-) {
-#if defined(_OPENMP)
-  matches.resize(omp_get_max_threads());
+  std::vector<potential_slab_t> slabs(omp_get_max_threads());
 #endif
+  for (auto &slab : slabs) {
+    slab.num_tts_sequences = tts_lengths.size();
+  }
+  std::vector<std::size_t> block_indices;
+  int min_qgram_hits = qgram_threshold(opts);
 
 #pragma omp parallel
   {
 #if !defined(_OPENMP)
-    tpx_finder_args_t tpx_args{matches, potentials, opts};
+    tpx_finder_args_t tpx_args{match_queue, slabs[0], opts};
 #else
-    tpx_finder_args_t tpx_args{matches[omp_get_thread_num()], opts};
+    tpx_finder_args_t tpx_args{match_queue, slabs[omp_get_thread_num()], opts};
 #endif
 
-    make_triplex_parser(tpx_args, opts.max_interruptions);
-
-    auto tfo_size = static_cast<uint64_t>(tfo_motifs.size());
-    auto tts_size = static_cast<uint64_t>(tts_motifs.size());
-#if defined(_OPENMP)
-    uint64_t chunk_size = std::min(tfo_size, tts_size);
-#endif
-
-#pragma omp for schedule(dynamic, chunk_size) collapse(2) nowait
-    for (uint64_t i = 0; i < tfo_size; i++) {
-      for (uint64_t j = 0; j < tts_size; j++) {
-        search_triplex(tfo_motifs[i], i, tts_motifs[j], j, tpx_args, opts);
-      }
+    // The index is only sound if every triplex is bound to share q-grams
+    tpx_args.min_qgram_hits = min_qgram_hits;
+    bool use_index = min_qgram_hits > 0;
+#pragma omp single
+    if (use_index) {
+      make_qgram_index(qgram_index, tts_candidates);
     }
 
-#if defined(_OPENMP)
-#pragma omp critical(potential_lock)
-    {
-      for (auto &potential_entry : tpx_args.potentials) {
-        auto result_ptr = potentials.find(potential_entry.first);
-        if (result_ptr == potentials.end()) {
-          potentials.insert(std::move(potential_entry));
-        } else {
-          seqan::mergeCount(result_ptr->second, potential_entry.second);
+#pragma omp for schedule(dynamic, 1)
+    for (std::size_t t = 0; t < tiles.size(); ++t) {
+      const auto &tile = tiles[t];
+      if (opts.tpx_backend == pato::tpx_backend_t::batched) {
+        search_triplex_batches(tfo_motifs, tfo_candidates, tile.tfo_range,
+                               tts_motifs, tts_candidates, tile.tts_range,
+                               use_index ? &qgram_index : nullptr, tpx_args,
+                               opts);
+        continue;
+      }
+      for (unsigned i = tile.tfo_range.begin; i < tile.tfo_range.end; ++i) {
+        for (unsigned tts_begin = tile.tts_range.begin;
+             tts_begin < tile.tts_range.end; tts_begin += tts_block_size) {
+          unsigned tts_end =
+              std::min(tts_begin + tts_block_size, tile.tts_range.end);
+          search_triplex_block(tfo_motifs, tfo_candidates, i, tts_motifs,
+                               tts_candidates, tts_begin, tts_end,
+                               use_index ? &qgram_index : nullptr, tpx_args,
+                               opts);
         }
       }
-    } // #pragma omp critical
-#endif
+    }
+    if (!tpx_args.matches.empty()) {
+      match_queue.push(tpx_args.matches);
+    }
+
+#pragma omp single
+    list_potential_blocks(block_indices, slabs);
+
+#pragma omp for schedule(static)
+    for (std::size_t i = 0; i < block_indices.size(); ++i) {
+      reduce_potentials(slabs, block_indices[i]);
+    }
   } // #pragma omp parallel
+
+  for (auto i : block_indices) {
+    const auto &block = slabs[0].blocks[i];
+    for (unsigned j = 0; j < potential_block_size; ++j) {
+      const auto &counts = (*block)[j];
+      if (counts.count_R == 0 && counts.count_Y == 0 && counts.count_M == 0) {
+        continue;
+      }
+
+      std::size_t cell = i * potential_block_size + j;
+      unsigned tfo_sequence = cell / tts_lengths.size();
+      unsigned tts_sequence = cell % tts_lengths.size();
+      pato::potential_t potential(std::make_pair(tfo_sequence, tts_sequence));
+      seqan::addCount(potential, counts.count_R, 'R');
+      seqan::addCount(potential, counts.count_Y, 'Y');
+      seqan::addCount(potential, counts.count_M, 'M');
+      seqan::setNorm(potential, tfo_lengths[tfo_sequence],
+                     tts_lengths[tts_sequence], opts.max_length,
+                     opts.min_length);
+      potentials.push_back(std::move(potential));
+    }
+  }
 }
 
 pato::find_tpx_result pato::find_tpxes(const pato::options_t &opts) {
@@ -293,52 +1001,56 @@ pato::find_tpx_result pato::find_tpxes(const pato::options_t &opts) {
   pato::name_vector_t tfo_names;
   pato::triplex_vector_t tfo_sequences;
   tfo_sequence_loader->load_sequences(tfo_sequences, tfo_names,
-                                      std::numeric_limits<unsigned>::max());
+                                      std::numeric_limits<unsigned>::max(),
+                                      std::numeric_limits<std::size_t>::max());
   pato::motif_vector_t tfo_motifs;
   pato::motif_potential_vector_t tfo_potentials;
   pato::find_tfo_motifs(tfo_motifs, tfo_potentials, tfo_sequences, opts);
 
+  candidate_buffer_t tfo_buffer;
+  make_candidates(tfo_buffer, tfo_motifs);
+  candidate_buffer_t tts_buffer;
+
   pato::name_vector_t tts_names;
   pato::triplex_vector_t tts_sequences;
   pato::motif_vector_t tts_motifs;
   pato::motif_potential_vector_t tts_potentials;
 
-#if !defined(_OPENMP)
-  pato::match_vector_t matches;
-#else
-  pato::match_vector_vector_t matches;
-#endif
-  pato::potential_map_t potentials;
+  pato::match_queue_t match_queue{match_queue_capacity};
+  pato::potential_vector_t potentials;
 
   while (true) {
-    if (!tts_sequence_loader->load_sequences(tts_sequences, tts_names,
-                                             opts.chunk_size)) {
+    if (!tts_sequence_loader->load_sequences(
+            tts_sequences, tts_names, opts.chunk_size, opts.chunk_bases)) {
       break;
     }
 
+    // The next chunk is read while this one is searched
+    tts_sequence_loader->prefetch_sequences(opts.chunk_size,
+                                             opts.chunk_bases);
+
     pato::find_tts_motifs(tts_motifs, tts_potentials, tts_sequences, opts);
-    match_tfo_tts_motifs(matches, potentials, tfo_motifs, tts_motifs, opts);
 
-#pragma omp parallel sections num_threads(2)
-    {
-#pragma omp section
-      output_writer->print_triplexes(matches, tfo_motifs, tfo_names, tts_motifs,
-                                     tts_names);
-#pragma omp section
-      output_writer->print_triplex_summary(potentials, tfo_names, tts_names);
-    } // #pragma omp parallel sections num_threads(2)
+    // The matches are printed as the workers find them, and the summary once
+    // all of them have been counted
+    match_queue.open();
+    std::thread writer{[&] {
+      pato::match_vector_t block;
+      while (match_queue.pop(block)) {
+        output_writer->print_triplexes(block, tfo_motifs, tfo_names,
+                                       tts_motifs, tts_names);
+        match_queue.recycle(block);
+      }
+    }};
+    match_tfo_tts_motifs(match_queue, potentials, tfo_motifs, tts_motifs,
+                         tfo_buffer, tts_buffer, opts);
+    match_queue.close();
+    output_writer->print_triplex_summary(potentials, tfo_names, tts_names);
+    writer.join();
 
     tts_names.clear();
     tts_motifs.clear();
     tts_sequences.clear();
-
-#if !defined(_OPENMP)
-    matches.clear();
-#else
-    for (auto &local_matches : matches) {
-      local_matches.clear();
-    }
-#endif
     potentials.clear();
   }
 
@@ -30,98 +30,151 @@
 #include "sequence_loader.h"
 #include "types.h"
 
+#include <algorithm>
+#include <numeric>
+
 namespace {
 
+// Bases of segments per work item. Segments are independent of each other, so
+// long sequences are split at segment boundaries and searched by several
+// threads at once.
+constexpr std::size_t tts_item_bases = 1 << 16;
+
+// Bases per segmentation window. Longer sequences are split into windows that
+// are segmented by several threads at once, and their repeats are found a few
+// subtrees at a time.
+constexpr std::size_t tts_window_bases = 1 << 18;
+
+// The repeats of a long sequence found in a range of subtrees of its suffix
+// tree, or the repeat filtering and segmentation of a whole short sequence
+struct tts_repeat_task_t {
+  unsigned sequence;
+  unsigned first_subtree;
+  unsigned last_subtree;
+  bool whole;
+};
+
+// A window of a long sequence, segmented for a single motif
+struct tts_window_t {
+  unsigned sequence;
+  std::size_t begin;
+  std::size_t end;
+  char motif;
+};
+
+// A run of consecutive segments of a sequence, all of them of the same motif
+struct tts_item_t {
+  unsigned sequence;
+  unsigned begin;
+  unsigned end;
+  char motif;
+  std::size_t length;
+};
+
+// Where the motifs found by a work item were left and how many there were
+struct tts_item_result_t {
+  unsigned thread;
+  std::size_t begin;
+  std::size_t end;
+  unsigned matches;
+};
+
 struct tts_finder_args_t {
-  pato::graph_t plus_parser;
-  pato::graph_t minus_parser;
+  pato::segment_parser_t plus_parser;
+  pato::segment_parser_t minus_parser;
 
   pato::repeat_vector_t repeats;
 
-#if !defined(_OPENMP)
   pato::motif_vector_t &motifs;
-  pato::motif_potential_vector_t &potentials;
-#else
-  pato::motif_vector_t motifs;
-  pato::motif_potential_vector_t potentials;
-#endif
 
-  pato::char_vector_vector_t block_runs;
-  pato::char_vector_vector_t encoded_seq;
-
-  pato::segment_vector_t segments;
+  pato::index_vector_t block_runs;
+  pato::encoded_sequence_t encoded_seq;
+  pato::window_bounds_t window_bounds;
 
   pato::guanine_filter_args_t filter_args;
 
-#if !defined(_OPENMP)
-  explicit tts_finder_args_t(pato::motif_vector_t &motifs_,
-                             pato::motif_potential_vector_t &potentials_)
-      : motifs{motifs_}, potentials{potentials_},
-        filter_args{motifs, block_runs, encoded_seq, true, 'G', 'Y'} {
+  explicit tts_finder_args_t(pato::motif_vector_t &motifs_)
+      : motifs{motifs_}, filter_args{motifs, block_runs, encoded_seq,
+                                     window_bounds, true, 'G', 'Y'} {
     filter_args.ornt = pato::orientation_t::both;
   }
-#else
-  tts_finder_args_t()
-      : filter_args{motifs, block_runs, encoded_seq, true, 'G', 'Y'} {
-    filter_args.ornt = pato::orientation_t::both;
-  }
-#endif
 };
 
 } // namespace
 
-static void make_tts_parsers(tts_finder_args_t &args, unsigned max_interrupts) {
+static void make_tts_parsers(tts_finder_args_t &args) {
   pato::triplex_t valid_chars, invalid_chars;
   valid_chars = "GAR";
   invalid_chars = "TCYN";
-  pato::make_parser(args.plus_parser, valid_chars, invalid_chars,
-                    max_interrupts);
+  pato::make_parser(args.plus_parser, valid_chars, invalid_chars);
 
   valid_chars = "TCY";
   invalid_chars = "GARN";
-  pato::make_parser(args.minus_parser, valid_chars, invalid_chars,
-                    max_interrupts);
+  pato::make_parser(args.minus_parser, valid_chars, invalid_chars);
 }
 
-static void find_tts_motifs(pato::triplex_t &sequence, unsigned id,
-                            tts_finder_args_t &args,
-                            const pato::options_t &opts) {
-  unsigned matches_plus = 0;
-  unsigned matches_minus = 0;
-
-  // + motif
-  pato::parse_segments(args.plus_parser, args.segments, sequence,
-                       opts.max_interruptions, opts.min_length);
-
-  for (auto &segment : args.segments) {
-    pato::motif_t motif{segment, true, id, false, '+'};
-    matches_plus +=
-        filter_guanine_error_rate(motif, args.filter_args, pato::tts_t{}, opts);
+static void parse_tts_segments(pato::triplex_t &sequence,
+                               pato::segment_vector_t &plus_segments,
+                               pato::segment_vector_t &minus_segments,
+                               tts_finder_args_t &args,
+                               const pato::options_t &opts) {
+  if (opts.filter_repeats) {
+    pato::filter_repeats(args.repeats, sequence, opts.min_repeat_length,
+                         opts.max_repeat_period);
   }
-  args.segments.clear();
 
-  // - motif
-  pato::parse_segments(args.minus_parser, args.segments, sequence,
+  // Both motifs are segmented in a single scan
+  std::array<pato::segment_lane_t, 2> lanes{
+      {{&args.plus_parser, &plus_segments},
+       {&args.minus_parser, &minus_segments}}};
+  pato::parse_segments(lanes.data(), lanes.size(), sequence,
                        opts.max_interruptions, opts.min_length);
+}
 
-  for (auto &segment : args.segments) {
-    pato::motif_t motif{segment, true, id, false, '-'};
-    matches_minus +=
-        filter_guanine_error_rate(motif, args.filter_args, pato::tts_t{}, opts);
+static void make_tts_windows(std::vector<tts_window_t> &windows,
+                             const pato::segment_parser_t &parser,
+                             const pato::triplex_t &sequence, unsigned id,
+                             char motif, const pato::options_t &opts) {
+  std::size_t length = seqan::length(sequence);
+
+  std::size_t begin = 0;
+  while (length - begin > tts_window_bases) {
+    std::size_t pos = pato::find_segment_break(
+        parser, sequence, begin + tts_window_bases, opts.max_interruptions);
+    if (pos >= length) {
+      break;
+    }
+    windows.push_back({id, begin, pos + 1, motif});
+    begin = pos + 1;
   }
-  args.segments.clear();
-
-  if (opts.run_mode == pato::run_mode_t::tts_search) {
-    pato::motif_potential_t potential{id};
-
-    seqan::addCount(potential, matches_plus, '+');
-    seqan::addCount(potential, matches_minus, '-');
+  windows.push_back({id, begin, length, motif});
+}
 
-    seqan::setNorm(potential, seqan::length(sequence), opts.max_length,
-                   opts.min_length);
+static void make_tts_items(std::vector<tts_item_t> &items,
+                           const pato::segment_vector_t &segments,
+                           unsigned sequence, char motif) {
+  unsigned begin = 0;
+  std::size_t length = 0;
+  for (unsigned i = 0; i < segments.size(); ++i) {
+    length += seqan::length(segments[i]);
+    if (length >= tts_item_bases || i + 1 == segments.size()) {
+      items.push_back({sequence, begin, i + 1, motif, length});
+      begin = i + 1;
+      length = 0;
+    }
+  }
+}
 
-    args.potentials.push_back(potential);
+static unsigned find_tts_motifs(pato::segment_vector_t &segments,
+                                const tts_item_t &item, tts_finder_args_t &args,
+                                const pato::options_t &opts) {
+  unsigned matches = 0;
+  for (unsigned i = item.begin; i < item.end; ++i) {
+    pato::motif_t motif{segments[i], true, item.sequence, false, item.motif};
+    matches +=
+        filter_guanine_error_rate(motif, args.filter_args, pato::tts_t{}, opts);
   }
+  return matches;
 }
 
 void pato::find_tts_motifs(pato::motif_vector_t &motifs,
@@ -135,45 +188,191 @@ void pato::find_tts_motifs(pato::motif_vector_t &motifs,
               return seqan::length(sequences[i]) > seqan::length(sequences[j]);
             });
 
+  std::vector<pato::segment_vector_t> plus_segments(sequences.size());
+  std::vector<pato::segment_vector_t> minus_segments(sequences.size());
+
+  // Long sequences are listed first, so their repeat tasks are scheduled
+  // before the short sequences and their windows are listed in order
+  std::vector<tts_repeat_task_t> tasks;
+  std::vector<pato::repeat_vector_t> task_repeats;
+  pato::index_vector_t task_begins;
+  unsigned num_long = 0;
+  while (num_long < indices.size() &&
+         seqan::length(sequences[indices[num_long]]) > tts_window_bases) {
+    ++num_long;
+  }
+
+  std::vector<std::vector<tts_window_t>> sequence_windows(num_long);
+  std::vector<tts_window_t> windows;
+  std::vector<pato::segment_vector_t> window_segments;
+
+  // Work items are listed in output order, sequence by sequence and + motifs
+  // first, and scheduled from the largest to the smallest
+  std::vector<tts_item_t> items;
+  pato::index_vector_t order;
+  std::vector<tts_item_result_t> results;
+
+#if !defined(_OPENMP)
+  std::vector<pato::motif_vector_t> thread_motifs(1);
+#else
+  std::vector<pato::motif_vector_t> thread_motifs(omp_get_max_threads());
+#endif
+
 #pragma omp parallel
   {
 #if !defined(_OPENMP)
-    tts_finder_args_t args{motifs, potentials};
+    unsigned thread = 0;
 #else
-    tts_finder_args_t args;
+    unsigned thread = omp_get_thread_num();
 #endif
+    tts_finder_args_t args{thread_motifs[thread]};
     if (opts.run_mode == pato::run_mode_t::tts_search) {
       args.filter_args.reduce_set = opts.merge_features;
     }
 
-    make_tts_parsers(args, opts.max_interruptions);
+    make_tts_parsers(args);
 
-#pragma omp for schedule(dynamic) nowait
-    for (unsigned i = 0; i < sequences.size(); ++i) {
-      if (opts.filter_repeats) {
-        pato::filter_repeats(args.repeats, sequences[indices[i]],
-                             opts.min_repeat_length, opts.max_repeat_period);
+#pragma omp single
+    {
+      // Every task builds the suffix tree of its whole sequence, so the
+      // subtrees of a long sequence are grouped into only as many tasks as
+      // there are threads to spare for it. With as many long sequences as
+      // threads, each of them builds a single tree.
+      unsigned num_tasks = num_long == 0 ? 1 : thread_motifs.size() / num_long;
+      num_tasks = std::max(num_tasks, 1u);
+
+      for (unsigned i = 0; i < indices.size(); ++i) {
+        task_begins.push_back(tasks.size());
+        if (i >= num_long) {
+          tasks.push_back({indices[i], 0, 0, true});
+        } else if (opts.filter_repeats) {
+          unsigned num_subtrees = pato::count_repeat_subtrees(
+              sequences[indices[i]], opts.max_repeat_period);
+          unsigned num_groups = std::min(num_tasks, num_subtrees);
+          for (unsigned j = 0; j < num_groups; ++j) {
+            tasks.push_back({indices[i], j * num_subtrees / num_groups,
+                             (j + 1) * num_subtrees / num_groups, false});
+          }
+        }
+      }
+      task_begins.push_back(tasks.size());
+      task_repeats.resize(tasks.size());
+    } // #pragma omp single
+
+#pragma omp for schedule(dynamic)
+    for (unsigned i = 0; i < tasks.size(); ++i) {
+      const auto &task = tasks[i];
+      if (task.whole) {
+        parse_tts_segments(sequences[task.sequence],
+                           plus_segments[task.sequence],
+                           minus_segments[task.sequence], args, opts);
+      } else {
+        pato::find_repeats(task_repeats[i], sequences[task.sequence],
+                           task.first_subtree, task.last_subtree,
+                           opts.min_repeat_length, opts.max_repeat_period);
       }
-      ::find_tts_motifs(sequences[indices[i]], indices[i], args, opts);
     }
 
-#if defined(_OPENMP)
-#pragma omp critical
+#pragma omp for schedule(dynamic)
+    for (unsigned i = 0; i < num_long; ++i) {
+      auto &sequence = sequences[indices[i]];
+      for (unsigned j = task_begins[i]; j < task_begins[i + 1]; ++j) {
+        pato::mask_repeats(sequence, task_repeats[j]);
+      }
+
+      make_tts_windows(sequence_windows[i], args.plus_parser, sequence,
+                       indices[i], '+', opts);
+      make_tts_windows(sequence_windows[i], args.minus_parser, sequence,
+                       indices[i], '-', opts);
+    }
+
+#pragma omp single
     {
-      motifs.reserve(motifs.size() + args.motifs.size());
-      std::move(args.motifs.begin(), args.motifs.end(),
-                std::back_inserter(motifs));
-    } // #pragma omp critical
-    if (opts.run_mode == run_mode_t::tts_search) {
-#pragma omp critical(potentials)
-      {
-        potentials.reserve(potentials.size() + args.potentials.size());
-        std::move(args.potentials.begin(), args.potentials.end(),
-                  std::back_inserter(potentials));
-      } // #pragma omp critical
+      for (auto &long_windows : sequence_windows) {
+        windows.insert(windows.end(), long_windows.begin(),
+                       long_windows.end());
+      }
+      window_segments.resize(windows.size());
+    } // #pragma omp single
+
+#pragma omp for schedule(dynamic)
+    for (unsigned i = 0; i < windows.size(); ++i) {
+      const auto &window = windows[i];
+      pato::segment_lane_t lane{
+          window.motif == '+' ? &args.plus_parser : &args.minus_parser,
+          &window_segments[i]};
+      pato::parse_segments(&lane, 1, sequences[window.sequence], window.begin,
+                           window.end, opts.max_interruptions,
+                           opts.min_length);
+    }
+
+#pragma omp single
+    {
+      for (unsigned i = 0; i < windows.size(); ++i) {
+        const auto &window = windows[i];
+        auto &segments = window.motif == '+' ? plus_segments[window.sequence]
+                                             : minus_segments[window.sequence];
+        std::move(window_segments[i].begin(), window_segments[i].end(),
+                  std::back_inserter(segments));
+      }
+
+      for (unsigned i = 0; i < sequences.size(); ++i) {
+        make_tts_items(items, plus_segments[i], i, '+');
+        make_tts_items(items, minus_segments[i], i, '-');
+      }
+
+      order.resize(items.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(),
+                [&](unsigned i, unsigned j) -> bool {
+                  return items[i].length > items[j].length;
+                });
+      results.resize(items.size());
+    } // #pragma omp single
+
+#pragma omp for schedule(dynamic)
+    for (unsigned i = 0; i < order.size(); ++i) {
+      const auto &item = items[order[i]];
+      auto &segments = item.motif == '+' ? plus_segments[item.sequence]
+                                         : minus_segments[item.sequence];
+
+      auto &result = results[order[i]];
+      result.thread = thread;
+      result.begin = args.motifs.size();
+      result.matches = ::find_tts_motifs(segments, item, args, opts);
+      result.end = args.motifs.size();
     }
-#endif
   } // #pragma omp parallel
+
+  pato::index_vector_t matches_plus(sequences.size(), 0);
+  pato::index_vector_t matches_minus(sequences.size(), 0);
+  for (unsigned i = 0; i < items.size(); ++i) {
+    const auto &item = items[i];
+    const auto &result = results[i];
+
+    auto &local_motifs = thread_motifs[result.thread];
+    std::move(local_motifs.begin() + result.begin,
+              local_motifs.begin() + result.end, std::back_inserter(motifs));
+    if (item.motif == '+') {
+      matches_plus[item.sequence] += result.matches;
+    } else {
+      matches_minus[item.sequence] += result.matches;
+    }
+  }
+
+  if (opts.run_mode == pato::run_mode_t::tts_search) {
+    for (unsigned i = 0; i < sequences.size(); ++i) {
+      pato::motif_potential_t potential{i};
+
+      seqan::addCount(potential, matches_plus[i], '+');
+      seqan::addCount(potential, matches_minus[i], '-');
+
+      seqan::setNorm(potential, seqan::length(sequences[i]), opts.max_length,
+                     opts.min_length);
+
+      potentials.push_back(potential);
+    }
+  }
 }
 
 pato::find_tts_motifs_result
@@ -195,9 +394,13 @@ pato::find_tts_motifs(const pato::options_t &opts) {
 
   while (true) {
     if (!sequence_loader->load_sequences(tts_sequences, tts_names,
-                                         opts.chunk_size)) {
+                                         opts.chunk_size, opts.chunk_bases)) {
       break;
     }
+
+    // The next chunk is read while this one is searched
+    sequence_loader->prefetch_sequences(opts.chunk_size, opts.chunk_bases);
+
     pato::find_tts_motifs(tts_motifs, tts_potentials, tts_sequences, opts);
 
 #pragma omp parallel sections num_threads(2)
@@ -23,7 +23,6 @@
 #ifndef PATO_LIB_TYPES_H
 #define PATO_LIB_TYPES_H
 
-#include <seqan/graph_types.h>
 #include <seqan/index.h>
 
 #include <Triplexator/alphabet.h>
@@ -37,10 +36,7 @@ using motif_t = seqan::ModStringTriplex<triplex_t, triplex_t>;
 using motif_potential_t = seqan::TriplexPotential<unsigned>;
 using repeat_t = seqan::Repeat<unsigned, unsigned>;
 using segment_t = seqan::Infix<triplex_t>::Type;
-using graph_t = seqan::Graph<seqan::Automaton<seqan::Triplex, seqan::Triplex>>;
-using vertex_descriptor_t = seqan::VertexDescriptor<graph_t>::Type;
-using filter_t =
-    seqan::ModifiedString<motif_t, seqan::ModView<seqan::FunctorRYFilter>>;
+using interval_t = std::pair<unsigned, unsigned>;
 using match_t =
     seqan::TriplexMatch<seqan::Difference<seqan::TriplexString>::Type, unsigned,
                         unsigned>;
@@ -52,23 +48,11 @@ using name_vector_t = std::vector<seqan::CharString>;
 using triplex_vector_t = std::vector<triplex_t>;
 using index_vector_t = std::vector<unsigned>;
 using repeat_vector_t = std::vector<repeat_t>;
-using char_vector_t = std::vector<char>;
-using char_vector_vector_t = std::vector<char_vector_t>;
+using word_vector_t = std::vector<uint64_t>;
 using segment_vector_t = std::vector<segment_t>;
+using interval_vector_t = std::vector<interval_t>;
 using match_vector_t = std::vector<match_t>;
-#if defined(_OPENMP)
-using match_vector_vector_t = std::vector<match_vector_t>;
-#endif
-
-struct pair_hash_t {
-  template <class Ty, class Tx>
-  std::size_t operator()(const std::pair<Ty, Tx> &pair) const {
-    return std::hash<Ty>()(pair.first) ^ std::hash<Tx>()(pair.second);
-  }
-};
-
-using potential_map_t =
-    std::unordered_map<std::pair<unsigned, unsigned>, potential_t, pair_hash_t>;
+using potential_vector_t = std::vector<potential_t>;
 
 } // namespace pato
 
@@ -79,9 +79,11 @@ declare -a tts_match_args=("" "-b 3 -a on")
 declare -a tts_filter_args=("" "-fr off")
 declare -a tts_merge_args=("" "-mf on")
 declare -a tts_output_args=("" "-po on")
+declare -a tts_chunk_args=("-cs 6" "-cb 1K")
 
 fails=0
 counter=0
+ref_counter=0
 printf "         \e[1mTTS search\e[0m\n"
 for len in "${tts_length_args[@]}"; do
   for err in "${tts_error_args[@]}"; do
@@ -89,33 +91,39 @@ for len in "${tts_length_args[@]}"; do
       for fil in "${tts_filter_args[@]}"; do
         for mer in "${tts_merge_args[@]}"; do
           for out in "${tts_output_args[@]}"; do
-            args="-cs 6 ${len} ${err} ${mat} ${fil} ${mer} ${out}"
+            ref=$ref_counter
+            ref_counter=$(($ref_counter + 1))
 
-            printf "\e[1m[  --  ]\e[0m Test #${counter} ${args}"
+            # chunking by sequences or by bases must not change the results
+            for chk in "${tts_chunk_args[@]}"; do
+              args="${chk} ${len} ${err} ${mat} ${fil} ${mer} ${out}"
 
-            sort $dir/ref/tts${counter}.out > $dir/output/tts${counter}.ref.sorted.out
-            sort $dir/ref/tts${counter}.summary > $dir/output/tts${counter}.ref.sorted.summary
+              printf "\e[1m[  --  ]\e[0m Test #${counter} ${args}"
 
-            $pato $args -ds $tts_file -o $dir/output/tts${counter} 1> /dev/null
-            sort $dir/output/tts${counter}.out > $dir/output/tts${counter}.sorted.out
-            sort $dir/output/tts${counter}.summary > $dir/output/tts${counter}.sorted.summary
+              sort $dir/ref/tts${ref}.out > $dir/output/tts${counter}.ref.sorted.out
+              sort $dir/ref/tts${ref}.summary > $dir/output/tts${counter}.ref.sorted.summary
 
-            diff $dir/output/tts${counter}.sorted.out $dir/output/tts${counter}.ref.sorted.out > $dir/output/tts${counter}.diff.out
-            diff $dir/output/tts${counter}.sorted.summary $dir/output/tts${counter}.ref.sorted.summary > $dir/output/tts${counter}.diff.summary
+              $pato $args -ds $tts_file -o $dir/output/tts${counter} 1> /dev/null
+              sort $dir/output/tts${counter}.out > $dir/output/tts${counter}.sorted.out
+              sort $dir/output/tts${counter}.summary > $dir/output/tts${counter}.sorted.summary
 
-            result=0
-            result=$(($result + $(wc -l < $dir/output/tts${counter}.diff.out)))
-            result=$(($result + $(wc -l < $dir/output/tts${counter}.diff.summary)))
+              diff $dir/output/tts${counter}.sorted.out $dir/output/tts${counter}.ref.sorted.out > $dir/output/tts${counter}.diff.out
+              diff $dir/output/tts${counter}.sorted.summary $dir/output/tts${counter}.ref.sorted.summary > $dir/output/tts${counter}.diff.summary
 
-            if [[ $result -eq 0 ]]; then
-              printf "\r\e[1m[  \033[0;32mOK\033[0m  \e[1m]\e[0m\n"
-              rm -rf $dir/output/tts${counter}*
-            else
-              printf "\r\e[1m[ \033[0;31mFAIL\033[0m \e[1m]\e[0m\n"
-              fails=$(($fails + 1))
-            fi
+              result=0
+              result=$(($result + $(wc -l < $dir/output/tts${counter}.diff.out)))
+              result=$(($result + $(wc -l < $dir/output/tts${counter}.diff.summary)))
 
-            counter=$(($counter + 1))
+              if [[ $result -eq 0 ]]; then
+                printf "\r\e[1m[  \033[0;32mOK\033[0m  \e[1m]\e[0m\n"
+                rm -rf $dir/output/tts${counter}*
+              else
+                printf "\r\e[1m[ \033[0;31mFAIL\033[0m \e[1m]\e[0m\n"
+                fails=$(($fails + 1))
+              fi
+
+              counter=$(($counter + 1))
+            done
           done
         done
       done
@@ -127,50 +135,139 @@ printf "         \e[1mRun:\e[0m ${counter} \e[1mOK\e[0m: $(($counter - $fails))
 total=$(($total + $counter))
 failed=$(($failed + $fails))
 
+# long tts tests
+declare -a tts_long_error_args=("" "-e 8 -E 10 -c 3 -g 50 -G 70")
+declare -a tts_long_filter_args=("" "-fr off" "-mrl 5 -mrp 3")
+declare -a tts_long_thread_args=("1" "4")
+
+# a single sequence long enough to be segmented in windows and to have its
+# repeats found a few subtrees at a time. An interrupted purine tract spans the
+# first window boundary, so the windows must be cut between segments.
+tts_long_file=$dir/output/tts_long.fa
+{
+  echo ">tts_long"
+  grep -hv "^>" $tts_file $tts_file $tfo_file | tr -d "\n" | awk '{
+    for (i = 261845; i <= 262444; ++i) {
+      c = substr($0, i, 1)
+      if (i % 25 != 0) {
+        c = c == "C" ? "A" : c == "T" ? "G" : c
+      }
+      tract = tract c
+    }
+    print substr($0, 1, 261844) tract substr($0, 262445)
+  }' | fold -w 60
+} > $tts_long_file
+
+fails=0
+counter=0
+ref_counter=0
+printf "         \e[1mLong TTS search\e[0m\n"
+for err in "${tts_long_error_args[@]}"; do
+  for fil in "${tts_long_filter_args[@]}"; do
+    ref=$ref_counter
+    ref_counter=$(($ref_counter + 1))
+
+    # the number of threads must not change the results
+    for thr in "${tts_long_thread_args[@]}"; do
+      args="${err} ${fil}"
+
+      printf "\e[1m[  --  ]\e[0m Test #${counter} ${args} (${thr} threads)"
+
+      sort $dir/ref/ttslong${ref}.out > $dir/output/ttslong${counter}.ref.sorted.out
+      sort $dir/ref/ttslong${ref}.summary > $dir/output/ttslong${counter}.ref.sorted.summary
+
+      OMP_NUM_THREADS=${thr} $pato $args -ds $tts_long_file -o $dir/output/ttslong${counter} 1> /dev/null
+      sort $dir/output/ttslong${counter}.out > $dir/output/ttslong${counter}.sorted.out
+      sort $dir/output/ttslong${counter}.summary > $dir/output/ttslong${counter}.sorted.summary
+
+      diff $dir/output/ttslong${counter}.sorted.out $dir/output/ttslong${counter}.ref.sorted.out > $dir/output/ttslong${counter}.diff.out
+      diff $dir/output/ttslong${counter}.sorted.summary $dir/output/ttslong${counter}.ref.sorted.summary > $dir/output/ttslong${counter}.diff.summary
+
+      result=0
+      result=$(($result + $(wc -l < $dir/output/ttslong${counter}.diff.out)))
+      result=$(($result + $(wc -l < $dir/output/ttslong${counter}.diff.summary)))
+
+      if [[ $result -eq 0 ]]; then
+        printf "\r\e[1m[  \033[0;32mOK\033[0m  \e[1m]\e[0m\n"
+        rm -rf $dir/output/ttslong${counter}*
+      else
+        printf "\r\e[1m[ \033[0;31mFAIL\033[0m \e[1m]\e[0m\n"
+        fails=$(($fails + 1))
+      fi
+
+      counter=$(($counter + 1))
+    done
+  done
+done
+printf "         \e[1mRun:\e[0m ${counter} \e[1mOK\e[0m: $(($counter - $fails)) \e[1mFAIL:\e[0m ${fails}\n\n"
+
+total=$(($total + $counter))
+failed=$(($failed + $fails))
+
 # tpx tests
 declare -a tpx_length_args=("" "-l 10 -L 14")
 declare -a tpx_error_args=("" "-e 8 -E 10 -c 3 -g 50 -G 70")
 declare -a tpx_match_args=("" "-b 3 -a on")
 declare -a tpx_filter_args=("" "-fr off")
 declare -a tpx_merge_args=("" "-er 1" "-er 2")
-declare -a tpx_output_args=("" "-of 1")
+declare -a tpx_output_args=("" "-of 1" "-of 2")
+declare -a tpx_backend_args=("" "-tb 1")
+declare -a tpx_chunk_args=("-cs 4" "-cb 1K")
 
 fails=0
 counter=0
+ref_counter=0
 printf "         \e[1mTPX search\e[0m\n"
 for len in "${tpx_length_args[@]}"; do
   for err in "${tpx_error_args[@]}"; do
     for mat in "${tpx_match_args[@]}"; do
       for fil in "${tpx_filter_args[@]}"; do
         for mer in "${tpx_merge_args[@]}"; do
-            for out in "${tpx_output_args[@]}"; do
-              args="-cs 4 ${len} ${err} ${mat} ${fil} ${mer} ${out}"
+          for out in "${tpx_output_args[@]}"; do
+            # the summary output writes no triplexes and the same summary as
+            # the default output
+            if [[ "${out}" == "-of 2" ]]; then
+              ref=$(($ref_counter - 2))
+              ref_out=/dev/null
+            else
+              ref=$ref_counter
+              ref_out=$dir/ref/tpx${ref}.out
+              ref_counter=$(($ref_counter + 1))
+            fi
 
-              printf "\e[1m[  --  ]\e[0m Test #${counter} ${args}"
+            # chunking by sequences or by bases must not change the results
+            for chk in "${tpx_chunk_args[@]}"; do
+              # both backends must report the same triplexes
+              for bak in "${tpx_backend_args[@]}"; do
+                args="${chk} ${len} ${err} ${mat} ${fil} ${mer} ${out} ${bak}"
 
-              sort $dir/ref/tpx${counter}.out > $dir/output/tpx${counter}.ref.sorted.out
-              sort $dir/ref/tpx${counter}.summary > $dir/output/tpx${counter}.ref.sorted.summary
+                printf "\e[1m[  --  ]\e[0m Test #${counter} ${args}"
 
-              $pato $args -ss $tfo_file -ds $tts_file -o $dir/output/tpx${counter} 1> /dev/null
-              sort $dir/output/tpx${counter}.out > $dir/output/tpx${counter}.sorted.out
-              sort $dir/output/tpx${counter}.summary > $dir/output/tpx${counter}.sorted.summary
+                sort $ref_out > $dir/output/tpx${counter}.ref.sorted.out
+                sort $dir/ref/tpx${ref}.summary > $dir/output/tpx${counter}.ref.sorted.summary
 
-              diff $dir/output/tpx${counter}.sorted.out $dir/output/tpx${counter}.ref.sorted.out > $dir/output/tpx${counter}.diff.out
-              diff $dir/output/tpx${counter}.sorted.summary $dir/output/tpx${counter}.ref.sorted.summary > $dir/output/tpx${counter}.diff.summary
+                $pato $args -ss $tfo_file -ds $tts_file -o $dir/output/tpx${counter} 1> /dev/null
+                sort $dir/output/tpx${counter}.out > $dir/output/tpx${counter}.sorted.out
+                sort $dir/output/tpx${counter}.summary > $dir/output/tpx${counter}.sorted.summary
 
-              result=0
-              result=$(($result + $(wc -l < $dir/output/tpx${counter}.diff.out)))
-              result=$(($result + $(wc -l < $dir/output/tpx${counter}.diff.summary)))
+                diff $dir/output/tpx${counter}.sorted.out $dir/output/tpx${counter}.ref.sorted.out > $dir/output/tpx${counter}.diff.out
+                diff $dir/output/tpx${counter}.sorted.summary $dir/output/tpx${counter}.ref.sorted.summary > $dir/output/tpx${counter}.diff.summary
 
-              if [[ $result -eq 0 ]]; then
-                printf "\r\e[1m[  \033[0;32mOK\033[0m  \e[1m]\e[0m\n"
-                rm -rf $dir/output/tpx${counter}*
-              else
-                printf "\r\e[1m[ \033[0;31mFAIL\033[0m \e[1m]\e[0m\n"
-                fails=$(($fails + 1))
-              fi
+                result=0
+                result=$(($result + $(wc -l < $dir/output/tpx${counter}.diff.out)))
+                result=$(($result + $(wc -l < $dir/output/tpx${counter}.diff.summary)))
 
-              counter=$(($counter + 1))
+                if [[ $result -eq 0 ]]; then
+                  printf "\r\e[1m[  \033[0;32mOK\033[0m  \e[1m]\e[0m\n"
+                  rm -rf $dir/output/tpx${counter}*
+                else
+                  printf "\r\e[1m[ \033[0;31mFAIL\033[0m \e[1m]\e[0m\n"
+                  fails=$(($fails + 1))
+                fi
+
+                counter=$(($counter + 1))
+              done
+            done
           done
         done
       done
@@ -182,6 +279,152 @@ printf "         \e[1mRun:\e[0m ${counter} \e[1mOK\e[0m: $(($counter - $fails))
 total=$(($total + $counter))
 failed=$(($failed + $fails))
 
+# long tpx tests
+declare -a tpx_long_error_args=("" "-e 8 -E 10 -c 3 -g 50 -G 70")
+declare -a tpx_long_merge_args=("" "-er 2")
+declare -a tpx_long_chunk_args=("-cs 1" "-cb 1K")
+
+# TFOs of 64 and more nucleotides do not fit in a word of the batched backend
+tfo_long_file=$dir/input/tfo_long.fa
+tts_long_file=$dir/input/tts_long.fa
+
+fails=0
+counter=0
+ref_counter=0
+printf "         \e[1mLong TPX search\e[0m\n"
+for err in "${tpx_long_error_args[@]}"; do
+  for mer in "${tpx_long_merge_args[@]}"; do
+    ref=$ref_counter
+    ref_counter=$(($ref_counter + 1))
+
+    for chk in "${tpx_long_chunk_args[@]}"; do
+      for bak in "${tpx_backend_args[@]}"; do
+        args="${chk} -L 0 ${err} ${mer} ${bak}"
+
+        printf "\e[1m[  --  ]\e[0m Test #${counter} ${args}"
+
+        sort $dir/ref/tpxlong${ref}.out > $dir/output/tpxlong${counter}.ref.sorted.out
+        sort $dir/ref/tpxlong${ref}.summary > $dir/output/tpxlong${counter}.ref.sorted.summary
+
+        $pato $args -ss $tfo_long_file -ds $tts_long_file -o $dir/output/tpxlong${counter} 1> /dev/null
+        sort $dir/output/tpxlong${counter}.out > $dir/output/tpxlong${counter}.sorted.out
+        sort $dir/output/tpxlong${counter}.summary > $dir/output/tpxlong${counter}.sorted.summary
+
+        diff $dir/output/tpxlong${counter}.sorted.out $dir/output/tpxlong${counter}.ref.sorted.out > $dir/output/tpxlong${counter}.diff.out
+        diff $dir/output/tpxlong${counter}.sorted.summary $dir/output/tpxlong${counter}.ref.sorted.summary > $dir/output/tpxlong${counter}.diff.summary
+
+        result=0
+        result=$(($result + $(wc -l < $dir/output/tpxlong${counter}.diff.out)))
+        result=$(($result + $(wc -l < $dir/output/tpxlong${counter}.diff.summary)))
+
+        if [[ $result -eq 0 ]]; then
+          printf "\r\e[1m[  \033[0;32mOK\033[0m  \e[1m]\e[0m\n"
+          rm -rf $dir/output/tpxlong${counter}*
+        else
+          printf "\r\e[1m[ \033[0;31mFAIL\033[0m \e[1m]\e[0m\n"
+          fails=$(($fails + 1))
+        fi
+
+        counter=$(($counter + 1))
+      done
+    done
+  done
+done
+printf "         \e[1mRun:\e[0m ${counter} \e[1mOK\e[0m: $(($counter - $fails)) \e[1mFAIL:\e[0m ${fails}\n\n"
+
+total=$(($total + $counter))
+failed=$(($failed + $fails))
+
+# compressed input tests
+declare -a gzip_format_args=("gz" "bgzf")
+declare -a gzip_search_args=("tfo" "tts" "tpx")
+declare -a gzip_chunk_args=("" "-cs 3" "-cb 100K")
+
+# compressed input is only read when PATO is compiled with zlib
+if grep -qs "^PATO_ENABLE_ZLIB:BOOL=OFF" $dir/../build/CMakeCache.txt; then
+  gzip_format_args=()
+fi
+
+# the gzip files are compressed here; the BGZF files, which gzip cannot
+# write, are part of the inputs
+gzip -c $tfo_file > $dir/output/tfo.fa.gz
+gzip -c $tts_file > $dir/output/tts.fa.gz
+cp $tfo_file.bgzf $tts_file.bgzf $dir/output
+
+fails=0
+counter=0
+printf "         \e[1mCompressed input\e[0m\n"
+for fmt in "${gzip_format_args[@]}"; do
+  for search in "${gzip_search_args[@]}"; do
+    for chk in "${gzip_chunk_args[@]}"; do
+      # the default search of every kind, read from compressed files
+      case ${search} in
+        tfo) files="-ss $dir/output/tfo.fa.${fmt}" ;;
+        tts) files="-ds $dir/output/tts.fa.${fmt}" ;;
+        tpx) files="-ss $dir/output/tfo.fa.${fmt} -ds $dir/output/tts.fa.${fmt}" ;;
+      esac
+      args="${chk}"
+
+      printf "\e[1m[  --  ]\e[0m Test #${counter} ${fmt} ${search} ${args}"
+
+      sort $dir/ref/${search}0.out > $dir/output/gzip${counter}.ref.sorted.out
+      sort $dir/ref/${search}0.summary > $dir/output/gzip${counter}.ref.sorted.summary
+
+      $pato $args $files -o $dir/output/gzip${counter} 1> /dev/null
+      sort $dir/output/gzip${counter}.out > $dir/output/gzip${counter}.sorted.out
+      sort $dir/output/gzip${counter}.summary > $dir/output/gzip${counter}.sorted.summary
+
+      diff $dir/output/gzip${counter}.sorted.out $dir/output/gzip${counter}.ref.sorted.out > $dir/output/gzip${counter}.diff.out
+      diff $dir/output/gzip${counter}.sorted.summary $dir/output/gzip${counter}.ref.sorted.summary > $dir/output/gzip${counter}.diff.summary
+
+      result=0
+      result=$(($result + $(wc -l < $dir/output/gzip${counter}.diff.out)))
+      result=$(($result + $(wc -l < $dir/output/gzip${counter}.diff.summary)))
+
+      if [[ $result -eq 0 ]]; then
+        printf "\r\e[1m[  \033[0;32mOK\033[0m  \e[1m]\e[0m\n"
+        rm -rf $dir/output/gzip${counter}*
+      else
+        printf "\r\e[1m[ \033[0;31mFAIL\033[0m \e[1m]\e[0m\n"
+        fails=$(($fails + 1))
+      fi
+
+      counter=$(($counter + 1))
+    done
+  done
+done
+printf "         \e[1mRun:\e[0m ${counter} \e[1mOK\e[0m: $(($counter - $fails)) \e[1mFAIL:\e[0m ${fails}\n\n"
+
+total=$(($total + $counter))
+failed=$(($failed + $fails))
+
+# invalid argument tests
+declare -a invalid_args=("-cb 12X" "-cb K" "-cb -1")
+
+fails=0
+counter=0
+printf "         \e[1mInvalid arguments\e[0m\n"
+for arg in "${invalid_args[@]}"; do
+  args="${arg}"
+
+  printf "\e[1m[  --  ]\e[0m Test #${counter} ${args}"
+
+  # PATO must refuse to run
+  if ! $pato $args -ss $tfo_file -ds $tts_file -o $dir/output/invalid${counter} 1> /dev/null; then
+    printf "\r\e[1m[  \033[0;32mOK\033[0m  \e[1m]\e[0m\n"
+    rm -rf $dir/output/invalid${counter}*
+  else
+    printf "\r\e[1m[ \033[0;31mFAIL\033[0m \e[1m]\e[0m\n"
+    fails=$(($fails + 1))
+  fi
+
+  counter=$(($counter + 1))
+done
+printf "         \e[1mRun:\e[0m ${counter} \e[1mOK\e[0m: $(($counter - $fails)) \e[1mFAIL:\e[0m ${fails}\n\n"
+
+total=$(($total + $counter))
+failed=$(($failed + $fails))
+
 # end the test suite and report the results
 printf "\e[1mRun:\e[0m ${total} \e[1mOK\e[0m: $(($total - $failed)) \e[1mFAIL:\e[0m ${failed}\n"
 
@@ -26,6 +26,8 @@
 #include <PATO/tts_finder.h>
 #include <seqan/arg_parse.h>
 
+#include <cctype>
+#include <limits>
 #include <variant>
 
 static void parse_motifs(const std::string &motifs, pato::options_t &opts) {
@@ -54,6 +56,44 @@ static void parse_motifs(const std::string &motifs, pato::options_t &opts) {
   }
 }
 
+// Parses a number of bases with an optional K, M or G suffix, where zero means
+// no limit at all
+static bool parse_bases(const std::string &bases, std::size_t &num_bases) {
+  std::size_t num_chars = 0;
+  unsigned long long value = 0;
+  try {
+    value = std::stoull(bases, &num_chars);
+  } catch (const std::exception &) {
+    return false;
+  }
+
+  unsigned long long multiplier = 1;
+  if (num_chars + 1 == bases.size()) {
+    switch (std::toupper(static_cast<unsigned char>(bases[num_chars]))) {
+    case 'K':
+      multiplier = 1000ULL;
+      break;
+    case 'M':
+      multiplier = 1000000ULL;
+      break;
+    case 'G':
+      multiplier = 1000000000ULL;
+      break;
+    default:
+      return false;
+    }
+  } else if (num_chars != bases.size() || bases[0] == '-') {
+    return false;
+  }
+
+  if (value > std::numeric_limits<std::size_t>::max() / multiplier) {
+    return false;
+  }
+  num_bases = value == 0 ? std::numeric_limits<std::size_t>::max()
+                         : value * multiplier;
+  return true;
+}
+
 static std::variant<int, pato::options_t> parse_command_line(int argc,
                                                              char *argv[]) {
   seqan::ArgumentParser parser{"PATO"};
@@ -195,6 +235,20 @@ static std::variant<int, pato::options_t> parse_command_line(int argc,
           "Maximum number of sequences that may be processed simultaneously "
           "(less simultaneous sequences equals less memory usage).",
           seqan::ArgParseOption::INTEGER});
+  seqan::addOption(
+      parser,
+      seqan::ArgParseOption{
+          "cb", "chunk-bases",
+          "Maximum number of bases that may be processed simultaneously, with "
+          "an optional K, M or G suffix (a chunk ends at the first sequence "
+          "that reaches it; 0 for no limit).",
+          seqan::ArgParseOption::STRING});
+  seqan::addOption(
+      parser, seqan::ArgParseOption{
+                  "tb", "triplex-backend",
+                  "Triplex scoring backend [0,1] (0: one TFO at a time; 1: "
+                  "batches of short TFOs scored together).",
+                  seqan::ArgParseOption::INTEGER});
 
   // input options
   seqan::setDefaultValue(parser, "ss", "(null)");
@@ -231,6 +285,9 @@ static std::variant<int, pato::options_t> parse_command_line(int argc,
 
   // performance options
   seqan::setDefaultValue(parser, "cs", 128);
+  seqan::setDefaultValue(parser, "cb", "0");
+  seqan::setDefaultValue(parser, "tb",
+                         static_cast<unsigned>(pato::tpx_backend_t::scalar));
 
   seqan::ArgumentParser::ParseResult result = seqan::parse(parser, argc, argv);
   switch (result) {
@@ -289,6 +346,14 @@ static std::variant<int, pato::options_t> parse_command_line(int argc,
 
   // performance options
   seqan::getOptionValue(opts.chunk_size, parser, "cs");
+  std::string chunk_bases;
+  seqan::getOptionValue(chunk_bases, parser, "cb");
+  bool valid_chunk_bases = parse_bases(chunk_bases, opts.chunk_bases);
+  {
+    unsigned tmp;
+    seqan::getOptionValue(tmp, parser, "tb");
+    opts.tpx_backend = pato::tpx_backend_t(tmp);
+  }
 
   // check options
   if (opts.tfo_file == "(null)" && opts.tts_file == "(null)") {
@@ -353,6 +418,15 @@ static std::variant<int, pato::options_t> parse_command_line(int argc,
     std::cerr << "PATO: the chunk size must be a positive number\n";
     return 1;
   }
+  if (!valid_chunk_bases) {
+    std::cerr << "PATO: the chunk bases must be a number of bases optionally "
+                 "followed by K, M or G\n";
+    return 1;
+  }
+  if (opts.tpx_backend >= pato::tpx_backend_t::last) {
+    std::cerr << "PATO: unknown triplex backend\n";
+    return 1;
+  }
 
   unsigned tolerated_error =
       static_cast<unsigned>(std::floor(opts.error_rate * opts.min_length));